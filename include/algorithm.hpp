@@ -5,19 +5,54 @@
 #include <memory>
 #include <set>
 #include <utility>
+#include <vector>
 
 #include "dataset.hpp"
 #include "distances.hpp"
+#include "neighbor_graph.hpp"
 #include "object.hpp"
+#include "object_store.hpp"
+#include "pattern.hpp"
+#include "table_instance.hpp"
 
 
-using Pattern = std::set<EventType>;
 using SubPatterns = std::pair<Pattern, Pattern>;
-using TableInstance = std::map<std::set<std::shared_ptr<Object>>, std::set<std::shared_ptr<Object>>>;
 
 
+struct TimeSlotTables {
+    // the work on a time slot which doesn't depend on the other time slots (nor on the object counts of the dataset), done before
+    // mining starts (see construct_dataset_pipelined)
+    std::shared_ptr<NeighborGraph> graph;
+    // the instances of the patterns of size 2 which have any in the time slot
+    std::map<Pattern, TableInstance> size2_tables;
+};
+
+
+bool exist_all_subsets(const Pattern&, const std::set<Pattern>&);
+std::map<Pattern, SubPatterns> apriori_gen(const std::set<Pattern>&);
+
+// the instances of the pattern of table1 joined with the ones of the pattern of table2, which differ only by their last event type
+// (with their diameters, if the tables have them)
+TableInstance join(const TableInstance& table1, const TableInstance& table2, const NeighborGraph&);
+
+// the number of distinct objects taking part to the instances of a pattern, for each of its event types in order
+std::vector<size_t> find_partecipating_object_counts(const Pattern&, const TableInstance&);
+// as above, only for the instances whose diameter is not greater than max_diameter (the table must have diameters)
+std::vector<size_t> find_partecipating_object_counts(const Pattern&, const TableInstance&, const float max_diameter);
+// the minimum partecipation ratio of the event types of a pattern (the maximum float if it has no instances)
+float find_partecipation_index(const std::vector<size_t>& object_count_by_event_type, const Pattern&,
+                               const std::vector<size_t>& partecipating_object_counts);
+
+void find_time_index(std::map<Pattern, float>& tp, const std::set<Pattern>& sp, const unsigned time_slot_count);
+std::set<Pattern> find_time_prev_co_occ(std::map<Pattern, float>& tp, const float time, const unsigned time_slot_count, const unsigned time_slot);
+void prune_non_closed_subsets(std::map<size_t, std::set<Pattern>>& cmdp, const Pattern&,
+                              const std::map<Pattern, std::vector<float>>& spatial_indexes_by_pattern);
+
+// the time slots with precomputed tables get their neighbor graph and their instances of size 2 from them instead of computing them
 std::map<size_t, std::set<Pattern>> mine_closed_mdcops(const std::set<EventType>&, const Dataset&, const std::pair<TimeSlot, unsigned>,
-                                                       const std::shared_ptr<INeighborRelation>, const float, const float);
+                                                       const std::shared_ptr<INeighborRelation>, const float, const float,
+                                                       const unsigned thread_count = 1,
+                                                       std::map<TimeSlot, TimeSlotTables> precomputed = std::map<TimeSlot, TimeSlotTables>());
 
 
 #endif  // ALGORITHM_HPP
@@ -0,0 +1,33 @@
+#ifndef BINARY_DATASET_HPP
+#define BINARY_DATASET_HPP
+
+#include <string>
+#include <utility>
+
+#include "dataset.hpp"
+#include "mapped_file.hpp"
+#include "object.hpp"
+
+
+// binary dataset files hold a Dataset as it is stored in memory, so that it can be loaded without parsing
+// all integers are in the byte order of the machine which wrote the file, and every section starts at a multiple of 8 bytes:
+//  - header: "MDCOPBIN", uint32 byte order mark 0x01020304, uint32 version, uint64 object count, uint64 event type count,
+//    uint64 time slot count
+//  - event type dictionary, for each event type in id order: uint64 object count, uint64 name size, name (padded)
+//  - time slot table, for each time slot in increasing order: uint64 time slot, uint64 index of its first object
+//  - columns, in the order of ObjectStore (by time slot, then by event type, then in file order): float x[], float y[],
+//    uint32 event type[], uint32 id[], uint32 time slot[] (each one padded)
+
+
+// write a dataset as a binary dataset file, returning false on failure
+bool write_binary_dataset(const Dataset&, const std::string& dataset_file_path);
+
+// check if a mapped file is a binary dataset file
+bool is_binary_dataset(const MappedFile&);
+
+// load a mapped binary dataset file, copying only the objects of the time slots of the window (see clamp_time_slots); throws
+// std::runtime_error if the file is malformed
+Dataset construct_binary_dataset(const MappedFile&, const std::pair<TimeSlot, unsigned> window);
+
+
+#endif  // BINARY_DATASET_HPP
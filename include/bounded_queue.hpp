@@ -0,0 +1,50 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+
+template<typename T>
+struct BoundedQueue {
+    // a queue between producer and consumer threads holding at most capacity items: producers wait while it is full, so that they
+    // can't get arbitrarily ahead of consumers, and consumers wait while it is empty until it is closed
+    const size_t capacity;
+    std::deque<T> items;
+    bool closed;
+    std::mutex mutex;
+    std::condition_variable not_full, not_empty;
+    
+    explicit BoundedQueue(size_t capacity) : capacity( capacity ), closed( false ) {}
+    
+    void push(T item) {
+        std::unique_lock<std::mutex> lock( mutex );
+        not_full.wait( lock, [this]() { return items.size() < capacity; } );
+        items.push_back( std::move( item ) );
+        not_empty.notify_one();
+    }
+    
+    // false once the queue is closed and empty
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock( mutex );
+        not_empty.wait( lock, [this]() { return !items.empty() || closed; } );
+        if ( items.empty() ) { return false; }
+        item = std::move( items.front() );
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+    
+    // no more items will be pushed
+    void close() {
+        std::lock_guard<std::mutex> lock( mutex );
+        closed = true;
+        not_empty.notify_all();
+    }
+};
+
+
+#endif  // BOUNDED_QUEUE_HPP
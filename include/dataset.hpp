@@ -1,23 +1,51 @@
 #ifndef DATASET_HPP
 #define DATASET_HPP
 
+#include <cstddef>
 #include <fstream>
-#include <map>
-#include <memory>
 #include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "object.hpp"
+#include "object_store.hpp"
 
 
 struct Dataset {
+    EventTypeDictionary event_type_dictionary;
     std::set<EventType> event_types;
-    std::set<std::shared_ptr<Object>> objects;
-    std::map<EventType, std::set<std::shared_ptr<Object>>> objects_by_event_type;
-    std::map<TimeSlot, std::set<std::shared_ptr<Object>>> objects_by_time_slot;
+    ObjectStore objects;
+    std::vector<size_t> object_count_by_event_type;
+    // the number of time slots of the whole dataset, even if only the objects of some of them were loaded
+    size_t time_slot_count;
 };
 
 
+// parse a line of a dataset file as "event_type_name x y time_slot", false if it is malformed; the event type name is the range of
+// the line it spans
+bool parse_line(const char* line, const char* line_end, std::pair<const char*, const char*>& event_type_name, float& x, float& y,
+                TimeSlot& time_slot);
+
+// read a dataset file whose lines are "event_type_name x y time_slot", skipping malformed lines
 Dataset construct_dataset(std::ifstream&);
+// as above, but scanning the file in place through a memory mapping, split in chunks (of at least min_chunk_size bytes) parsed by up
+// to thread_count threads; files which can't be mapped are read as streams
+// only the objects of the time slots of the window (see clamp_time_slots) are kept, but object_count_by_event_type and time_slot_count
+// still describe the whole dataset (except for streams, which are read whole)
+// binary dataset files (see binary_dataset.hpp) are recognized and loaded without parsing
+Dataset construct_dataset(const std::string& dataset_file_path, unsigned thread_count = 1,
+                          std::pair<TimeSlot, unsigned> window = { 0, ~0u }, size_t min_chunk_size = 4 << 20);
+
+// clamp a window of time slots (the first time slot and the number of time slots) to a dataset with the given number of time slots,
+// as main does once the dataset is loaded
+std::pair<TimeSlot, unsigned> clamp_time_slots(std::pair<TimeSlot, unsigned> window, size_t time_slot_count);
+
+// the object count of each event type in the time slots of the window
+std::vector<size_t> window_object_count_by_event_type(const Dataset&, std::pair<TimeSlot, unsigned> window);
+// the partecipation ratios of a pattern are computed against the object count of each event type in the whole dataset; make them
+// computed against the object count of each event type in the time slots of the window instead
+void restrict_denominators_to_window(Dataset&, std::pair<TimeSlot, unsigned> window);
 
 void print_dataset_info(const Dataset&);
 
@@ -1,35 +1,252 @@
 #ifndef DISTANCES_HPP
 #define DISTANCES_HPP
 
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
+#include "neighbor_kernels.hpp"
 #include "object.hpp"
+#include "object_store.hpp"
 
 
 struct INeighborRelation {
     virtual ~INeighborRelation() {}
 
-    virtual bool neighbors(const std::shared_ptr<Object>&, const std::shared_ptr<Object>&) = 0;
+    virtual bool neighbors(const Object&, const Object&) = 0;
+    // a measure of how far apart two objects are, which orders pairs of objects as their distance does: two objects are neighbors
+    // exactly when their separation is not greater than max_separation, so the neighbors for a smaller threshold are the ones
+    // whose separation is not greater than its max_separation
+    virtual float separation(const Object&, const Object&) = 0;
+    virtual float max_separation() const = 0;
 };
 
 
+// the loops testing many pairs of objects (see NeighborGraph) are templated on the relation, and called once with the relation as
+// one of the final distances below: they test the pairs of a range of objects of a store with the Kernel the relation gives for
+// them, whose calls are then inlined; any other relation goes through VirtualNeighborRelation, which calls INeighborRelation for
+// every pair
+// besides testing a pair, a kernel tests an object against a block of up to NEIGHBOR_BLOCK_SIZE consecutive objects at once, giving
+// the bitmask of its neighbors among them (see neighbor_kernels.hpp)
 
-struct EuclideanDistance : public INeighborRelation {
+template<typename Kernel>
+uint64_t neighbors_one_by_one(const Kernel& kernel, ObjectIndex object1, ObjectIndex first, unsigned count) {
+    uint64_t mask = 0;
+    for ( unsigned i = 0; i < count; ++i ) {
+        if ( kernel.neighbors( object1, first+i ) ) { mask |= uint64_t( 1 ) << i; }
+    }
+    return mask;
+}
+
+struct VirtualNeighborRelation {
+    INeighborRelation& r;
+    
+    struct Kernel {
+        INeighborRelation& r;
+        const ObjectStore& st;
+        
+        bool neighbors(ObjectIndex object1, ObjectIndex object2) const { return r.neighbors( st.object( object1 ), st.object( object2 ) ); }
+        float separation(ObjectIndex object1, ObjectIndex object2) const { return r.separation( st.object( object1 ), st.object( object2 ) ); }
+        uint64_t neighbors(ObjectIndex object1, ObjectIndex first, unsigned count) const {
+            return neighbors_one_by_one( *this, object1, first, count );
+        }
+    };
+    
+    explicit VirtualNeighborRelation(INeighborRelation& r) : r( r ) {}
+    
+    Kernel kernel(const ObjectStore& st, const ObjectRange) const { return { r, st }; }
+};
+
+
+
+struct EuclideanDistance final : public INeighborRelation {
+    const float dt;
     const float squared_dt;
     
+    struct Kernel {
+        const EuclideanDistance& r;
+        const ObjectStore& st;
+        
+        bool neighbors(ObjectIndex object1, ObjectIndex object2) const {
+            return r.neighbors( st.x[object1], st.y[object1], st.x[object2], st.y[object2] );
+        }
+        float separation(ObjectIndex object1, ObjectIndex object2) const {
+            return r.separation( st.x[object1], st.y[object1], st.x[object2], st.y[object2] );
+        }
+        uint64_t neighbors(ObjectIndex object1, ObjectIndex first, unsigned count) const {
+            return euclidean_neighbors( st.x[object1], st.y[object1], st.x.data() + first, st.y.data() + first, count, r.squared_dt );
+        }
+    };
+    
     EuclideanDistance(float);
     
-    virtual bool neighbors(const std::shared_ptr<Object>&, const std::shared_ptr<Object>&);
+    // the squared distance
+    float separation(float x1, float y1, float x2, float y2) const {
+        const float dx = x1-x2;
+        const float dy = y1-y2;
+        return dx*dx + dy*dy;
+    }
+    bool neighbors(float x1, float y1, float x2, float y2) const { return separation( x1, y1, x2, y2 ) <= squared_dt; }
+    
+    Kernel kernel(const ObjectStore& st, const ObjectRange) const { return { *this, st }; }
+    
+    virtual bool neighbors(const Object& object1, const Object& object2) { return neighbors( object1.x, object1.y, object2.x, object2.y ); }
+    virtual float separation(const Object& object1, const Object& object2) { return separation( object1.x, object1.y, object2.x, object2.y ); }
+    virtual float max_separation() const { return squared_dt; }
 };
 
 
 
-struct LatLonDistance : public INeighborRelation {
+struct LatLonDistance final : public INeighborRelation {
+    // pairs of objects are first tested against a bounding box around the first object (a band of latitudes and a window of
+    // longitudes which holds the circle of dt km around it), which rejects most of the pairs far apart without trigonometry; the
+    // box is widened beyond the rounding of the distance, so it never rejects a pair the distance would accept
     const float dt;
+    const float latitude_band;  // the greatest difference of latitude of two neighbors, in degrees
+    // the pairs the kernels tested a block at a time, and the ones of them the bounding boxes rejected
+    mutable std::atomic<size_t> box_test_count, box_rejected_count;
+    
+    struct Kernel {
+        const LatLonDistance& r;
+        const ObjectStore& st;
+        const ObjectIndex first_object;
+        std::vector<float> longitude_windows;  // of the objects of a range, see longitude_window
+        
+        bool in_box(ObjectIndex object1, ObjectIndex object2) const {
+            if ( std::fabs( st.x[object2]-st.x[object1] ) > r.latitude_band ) { return false; }
+            // the difference of longitude the short way around, also across the antimeridian
+            float dlon = std::fabs( st.y[object2]-st.y[object1] );
+            if ( dlon > 180 ) { dlon = std::fabs( std::remainder( dlon, 360.f ) ); }
+            return dlon <= longitude_windows[object1-first_object];
+        }
+        bool neighbors(ObjectIndex object1, ObjectIndex object2) const {
+            return in_box( object1, object2 ) && r.neighbors( st.x[object1], st.y[object1], st.x[object2], st.y[object2] );
+        }
+        float separation(ObjectIndex object1, ObjectIndex object2) const {
+            return r.separation( st.x[object1], st.y[object1], st.x[object2], st.y[object2] );
+        }
+        uint64_t neighbors(ObjectIndex object1, ObjectIndex first, unsigned count) const {
+            uint64_t mask = 0;
+            size_t rejected_count = 0;
+            for ( unsigned i = 0; i < count; ++i ) {
+                const ObjectIndex object2 = first+i;
+                if ( !in_box( object1, object2 ) ) { ++rejected_count; }
+                else if ( r.neighbors( st.x[object1], st.y[object1], st.x[object2], st.y[object2] ) ) { mask |= uint64_t( 1 ) << i; }
+            }
+            r.box_test_count.fetch_add( count, std::memory_order_relaxed );
+            r.box_rejected_count.fetch_add( rejected_count, std::memory_order_relaxed );
+            return mask;
+        }
+    };
     
     LatLonDistance(float);
     
-    virtual bool neighbors(const std::shared_ptr<Object>&, const std::shared_ptr<Object>&);
+    // the distance in km (x is the latitude, y the longitude), see http://www.movable-type.co.uk/scripts/latlong.html
+    float separation(float lat1, float lon1, float lat2, float lon2) const {
+        static const float R = 6371;  // km
+        const float phi1 = deg_to_rad( lat1 );
+        const float phi2 = deg_to_rad( lat2 );
+        const float dphi = deg_to_rad( lat2-lat1 );
+        const float dlambda = deg_to_rad( lon2-lon1 );
+        
+        const float a = sinf( dphi/2 ) * sinf( dphi/2 ) + cosf( phi1 ) * cosf( phi2 ) * sinf( dlambda/2 ) * sinf( dlambda/2 );
+        const float c = 2 * atan2f( sqrtf( a ), sqrtf( 1-a ) );
+        
+        return R * c;
+    }
+    bool neighbors(float lat1, float lon1, float lat2, float lon2) const { return separation( lat1, lon1, lat2, lon2 ) <= dt; }
+    
+    // the greatest difference of longitude, in degrees, of a neighbor of an object at a latitude: 180 if the circle around the
+    // object reaches a pole (then its neighbors can have any longitude)
+    float longitude_window(float lat) const;
+    
+    Kernel kernel(const ObjectStore& st, const ObjectRange range) const {
+        Kernel kernel{ *this, st, range.first, {} };
+        kernel.longitude_windows.reserve( range.second-range.first );
+        for ( ObjectIndex object = range.first; object < range.second; ++object ) {
+            kernel.longitude_windows.push_back( longitude_window( st.x[object] ) );
+        }
+        return kernel;
+    }
+    
+    virtual bool neighbors(const Object& object1, const Object& object2) { return neighbors( object1.x, object1.y, object2.x, object2.y ); }
+    virtual float separation(const Object& object1, const Object& object2) { return separation( object1.x, object1.y, object2.x, object2.y ); }
+    virtual float max_separation() const { return dt; }
+    
+    static float deg_to_rad(float deg) { return deg * 3.14159265358979323846/180; }
+};
+
+
+
+struct LatLonChordDistance final : public INeighborRelation {
+    // the distance on the sphere of LatLonDistance without trigonometry for each pair: each object is a point of the unit sphere,
+    // and two objects are within dt km exactly when the chord between their points is within the chord of an arc of dt km, so a
+    // pair only takes a dot product; decisions differ from the ones of LatLonDistance only for pairs whose distance is within
+    // rounding of dt, which is about 1e-7 of dt for the chord and up to about 2e-4 of dt for the float haversine (see the tests)
+    const float dt;
+    const float squared_chord;  // the squared chord of an arc of dt km on the unit sphere
+    
+    struct UnitVector {
+        double x, y, z;
+    };
+    
+    struct Kernel {
+        // the unit vectors of the objects of a range, each computed once, as arrays of coordinates
+        const LatLonChordDistance& r;
+        const ObjectIndex first_object;
+        std::vector<double> xs, ys, zs;
+        
+        UnitVector unit_vector(ObjectIndex object) const {
+            return { xs[object-first_object], ys[object-first_object], zs[object-first_object] };
+        }
+        bool neighbors(ObjectIndex object1, ObjectIndex object2) const { return separation( object1, object2 ) <= r.squared_chord; }
+        float separation(ObjectIndex object1, ObjectIndex object2) const { return r.separation( unit_vector( object1 ), unit_vector( object2 ) ); }
+        uint64_t neighbors(ObjectIndex object1, ObjectIndex first, unsigned count) const {
+            const UnitVector u1 = unit_vector( object1 );
+            return chord_neighbors( u1.x, u1.y, u1.z, xs.data() + (first-first_object), ys.data() + (first-first_object),
+                                    zs.data() + (first-first_object), count, r.squared_chord );
+        }
+    };
+    
+    LatLonChordDistance(float);
+    
+    // the point of the unit sphere at a latitude and longitude
+    static UnitVector unit_vector(float lat, float lon) {
+        const double phi = lat * 3.14159265358979323846/180;
+        const double lambda = lon * 3.14159265358979323846/180;
+        return { std::cos( phi ) * std::cos( lambda ), std::cos( phi ) * std::sin( lambda ), std::sin( phi ) };
+    }
+    // the squared chord between two points of the unit sphere (the dot product of their difference with itself, which unlike
+    // 2 - 2*u1.u2 keeps its precision for close points)
+    float separation(const UnitVector& u1, const UnitVector& u2) const {
+        const double dx = u1.x-u2.x;
+        const double dy = u1.y-u2.y;
+        const double dz = u1.z-u2.z;
+        return (float) (dx*dx + dy*dy + dz*dz);
+    }
+    
+    Kernel kernel(const ObjectStore& st, const ObjectRange range) const {
+        Kernel kernel{ *this, range.first, {}, {}, {} };
+        kernel.xs.reserve( range.second-range.first );
+        kernel.ys.reserve( range.second-range.first );
+        kernel.zs.reserve( range.second-range.first );
+        for ( ObjectIndex object = range.first; object < range.second; ++object ) {
+            const UnitVector u = unit_vector( st.x[object], st.y[object] );
+            kernel.xs.push_back( u.x );
+            kernel.ys.push_back( u.y );
+            kernel.zs.push_back( u.z );
+        }
+        return kernel;
+    }
+    
+    virtual bool neighbors(const Object& object1, const Object& object2) { return separation( object1, object2 ) <= squared_chord; }
+    virtual float separation(const Object& object1, const Object& object2) {
+        return separation( unit_vector( object1.x, object1.y ), unit_vector( object2.x, object2.y ) );
+    }
+    virtual float max_separation() const { return squared_chord; }
 };
 
 
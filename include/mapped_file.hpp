@@ -0,0 +1,24 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+
+struct MappedFile {
+    // a read-only memory mapping of a whole regular file, so that it can be scanned in place without copying it
+    // files which can't be mapped (e.g. pipes, or any file on platforms without mmap) are left unmapped: mapped is false and the
+    // caller should read them as streams instead
+    bool mapped;
+    const char* data;
+    size_t size;
+    
+    explicit MappedFile(const std::string& file_path);
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
+
+#endif  // MAPPED_FILE_HPP
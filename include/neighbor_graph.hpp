@@ -0,0 +1,38 @@
+#ifndef NEIGHBOR_GRAPH_HPP
+#define NEIGHBOR_GRAPH_HPP
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "distances.hpp"
+#include "object.hpp"
+#include "object_store.hpp"
+
+
+struct NeighborGraph {
+    // neighbor relationships between the objects of a time slot, computed once and shared by the joins of every pattern size
+    
+    // the objects of the time slot
+    const ObjectRange objects;
+    // compressed sparse row adjacency: the neighbors of object objects.first+i are neighbors[offsets[i]..offsets[i+1]), sorted; only
+    // neighbors with an event type greater than the one of the object (i.e. with a greater index) are stored, as the join always
+    // looks up the object with the smaller event type of a pair
+    std::vector<size_t> offsets;
+    std::vector<ObjectIndex> neighbors;
+    // if the graph was built with them, the separation of each pair of neighbors (see INeighborRelation), parallel to neighbors
+    std::vector<float> separations;
+    
+    NeighborGraph(const ObjectStore&, const TimeSlot, const std::shared_ptr<INeighborRelation>);
+    // as above, for a store holding a single time slot whose objects are stored from first_object on in the dataset: the graph
+    // refers to objects by their index in the dataset
+    NeighborGraph(const ObjectStore&, const TimeSlot, const std::shared_ptr<INeighborRelation>, const ObjectIndex first_object,
+                  const bool with_separations = false);
+    
+    // the neighbors of an object of the time slot
+    std::pair<const ObjectIndex*, const ObjectIndex*> neighbors_of(ObjectIndex) const;
+};
+
+
+#endif  // NEIGHBOR_GRAPH_HPP
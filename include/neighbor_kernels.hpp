@@ -0,0 +1,29 @@
+#ifndef NEIGHBOR_KERNELS_HPP
+#define NEIGHBOR_KERNELS_HPP
+
+#include <cstdint>
+#include <string>
+
+
+// batched neighbor tests of one probe object against a block of up to NEIGHBOR_BLOCK_SIZE candidates, whose coordinates are given as
+// arrays: the result is the bitmask of the candidates which are neighbors of the probe (bit i for the i-th candidate)
+// each test has a scalar version and SIMD versions, one of which is chosen at startup from the features of the CPU; they all take the
+// decisions of the kernels of the relations in distances.hpp (the same float operations are done, only several at once)
+
+const unsigned NEIGHBOR_BLOCK_SIZE = 64;
+
+// the candidates whose squared distance from (x, y) is not greater than squared_dt (see EuclideanDistance)
+uint64_t euclidean_neighbors(float x, float y, const float* xs, const float* ys, unsigned count, float squared_dt);
+// the candidates whose squared chord from the point (x, y, z) of the unit sphere is not greater than squared_chord (see
+// LatLonChordDistance)
+uint64_t chord_neighbors(double x, double y, double z, const double* xs, const double* ys, const double* zs, unsigned count,
+                         float squared_chord);
+
+// the instruction set of the versions in use: "avx2", "sse2" or "scalar"
+const char* neighbor_kernels_instruction_set();
+// use the versions of the given instruction set instead (e.g. to compare them), if the CPU supports it; not to be called while
+// other threads test neighbors
+bool set_neighbor_kernels_instruction_set(const std::string&);
+
+
+#endif  // NEIGHBOR_KERNELS_HPP
@@ -4,20 +4,35 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 
-using EventType = std::string;
+using EventType = unsigned;  // dense id of an event type name, see EventTypeDictionary
 using ObjectId = unsigned;
 using TimeSlot = unsigned;
 
 
+struct EventTypeDictionary {
+    // event types are interned as soon as they are read, so that the miner only compares and stores small integers;
+    // names are only needed again to print results
+    std::vector<std::string> names;
+    std::unordered_map<std::string, EventType> event_types_by_name;
+    
+    // get the event type of a name, assigning the next free id if the name is new
+    EventType intern(const std::string&);
+    
+    const std::string& name(EventType) const;
+};
+
+
 struct Object {
     const EventType event_type;
     const ObjectId id;
     const float x, y;
     const TimeSlot time_slot;
     
-    Object(EventType, unsigned, float, float, unsigned);
+    Object(EventType, ObjectId, float, float, TimeSlot);
 };
 
 std::ostream& operator<<(std::ostream&, const Object&);
@@ -0,0 +1,47 @@
+#ifndef OBJECT_STORE_HPP
+#define OBJECT_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "object.hpp"
+
+
+using ObjectIndex = uint32_t;
+using ObjectRange = std::pair<ObjectIndex, ObjectIndex>;  // the objects [first, second)
+
+
+struct ObjectStore {
+    // columnar storage of the objects of a dataset, sorted by time slot, then by event type, then in the order they were added:
+    // an object is identified by its index in the columns, so the objects of a time slot (and the objects of an event type in a
+    // time slot) are contiguous, and sorting objects of a time slot by index also sorts them by event type
+    std::vector<EventType> event_type;
+    std::vector<ObjectId> id;
+    std::vector<float> x, y;
+    std::vector<TimeSlot> time_slot;
+    
+    std::map<TimeSlot, ObjectRange> ranges_by_time_slot;
+    
+    ObjectStore() {}
+    explicit ObjectStore(const std::vector<Object>&);
+    // from the columns of the objects in the order they were added
+    ObjectStore(const std::vector<EventType>&, const std::vector<ObjectId>&, const std::vector<float>&, const std::vector<float>&,
+                const std::vector<TimeSlot>&);
+    
+    size_t size() const { return event_type.size(); }
+    
+    Object object(ObjectIndex) const;
+    
+    // the objects of a time slot (an empty range if the time slot has no objects)
+    ObjectRange time_slot_range(TimeSlot) const;
+    // the objects of an event type among the given range, which must be sorted by event type
+    ObjectRange event_type_range(ObjectRange, EventType) const;
+    // the event types of the objects of a time slot, each with its objects
+    std::vector<std::pair<EventType, ObjectRange>> event_type_ranges(TimeSlot) const;
+};
+
+
+#endif  // OBJECT_STORE_HPP
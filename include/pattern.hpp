@@ -0,0 +1,185 @@
+#ifndef PATTERN_HPP
+#define PATTERN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "object.hpp"
+
+
+inline unsigned popcount64(uint64_t word) {
+#if defined(__GNUC__)
+    return (unsigned) __builtin_popcountll( word );
+#else
+    unsigned count = 0;
+    for ( ; word; word &= word-1 ) { ++count; }
+    return count;
+#endif
+}
+
+inline unsigned lowest_bit64(uint64_t word) {
+    // word must not be zero
+#if defined(__GNUC__)
+    return (unsigned) __builtin_ctzll( word );
+#else
+    unsigned bit = 0;
+    for ( ; !(word & 1); word >>= 1 ) { ++bit; }
+    return bit;
+#endif
+}
+
+inline unsigned highest_bit64(uint64_t word) {
+    // word must not be zero
+#if defined(__GNUC__)
+    return 63 - (unsigned) __builtin_clzll( word );
+#else
+    unsigned bit = 0;
+    for ( ; word >>= 1; ) { ++bit; }
+    return bit;
+#endif
+}
+
+
+struct Pattern {
+    // a set of event types stored as a bitmask: event type i belongs to the pattern if bit i is set
+    // event types 0..63 live in an inline word, so patterns of datasets with at most 64 event types never allocate; the others live in
+    // words[0], words[1], ... (event types 64..127, 128..191, ...), which never end with a zero word so that equal patterns have
+    // equal members
+    uint64_t word;
+    std::vector<uint64_t> words;
+
+    struct const_iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = EventType;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const EventType*;
+        using reference = EventType;
+
+        const Pattern* pattern;
+        EventType event_type;  // NO_EVENT_TYPE at the end
+
+        EventType operator*() const { return event_type; }
+        const_iterator& operator++() { event_type = pattern->next( event_type+1 ); return *this; }
+        const_iterator operator++(int) { const_iterator i = *this; ++*this; return i; }
+        bool operator==(const const_iterator& other) const { return event_type == other.event_type; }
+        bool operator!=(const const_iterator& other) const { return event_type != other.event_type; }
+    };
+    using iterator = const_iterator;
+    using value_type = EventType;
+
+    static const EventType NO_EVENT_TYPE = ~0u;
+
+    Pattern() : word( 0 ) {}
+    Pattern(std::initializer_list<EventType> event_types) : word( 0 ) {
+        for ( const EventType event_type : event_types ) { insert( event_type ); }
+    }
+
+    void insert(EventType event_type) {
+        if ( event_type < 64 ) { word |= uint64_t( 1 ) << event_type; return; }
+        const size_t i = event_type/64 - 1;
+        if ( i >= words.size() ) { words.resize( i+1, 0 ); }
+        words[i] |= uint64_t( 1 ) << (event_type % 64);
+    }
+    void erase(EventType event_type) {
+        if ( event_type < 64 ) { word &= ~(uint64_t( 1 ) << event_type); return; }
+        const size_t i = event_type/64 - 1;
+        if ( i >= words.size() ) { return; }
+        words[i] &= ~(uint64_t( 1 ) << (event_type % 64));
+        while ( !words.empty() && words.back() == 0 ) { words.pop_back(); }
+    }
+    bool count(EventType event_type) const {
+        if ( event_type < 64 ) { return (word >> event_type) & 1; }
+        const size_t i = event_type/64 - 1;
+        return i < words.size() && ((words[i] >> (event_type % 64)) & 1);
+    }
+
+    size_t size() const {
+        size_t size = popcount64( word );
+        for ( const uint64_t w : words ) { size += popcount64( w ); }
+        return size;
+    }
+    bool empty() const { return word == 0 && words.empty(); }
+
+    // the smallest event type of the pattern greater or equal than event_type, or NO_EVENT_TYPE
+    EventType next(EventType event_type) const {
+        if ( event_type == NO_EVENT_TYPE ) { return NO_EVENT_TYPE; }
+        if ( event_type < 64 ) {
+            const uint64_t w = word & (~uint64_t( 0 ) << event_type);
+            if ( w ) { return lowest_bit64( w ); }
+            event_type = 64;
+        }
+        for ( size_t i = event_type/64 - 1; i < words.size(); ++i ) {
+            const uint64_t w = words[i] & (~uint64_t( 0 ) << (event_type % 64));
+            if ( w ) { return (EventType) (64*(i+1) + lowest_bit64( w )); }
+            event_type = (EventType) (64*(i+2));
+        }
+        return NO_EVENT_TYPE;
+    }
+    // the greatest event type of the pattern, which must not be empty
+    EventType last() const {
+        if ( !words.empty() ) { return (EventType) (64*words.size() + highest_bit64( words.back() )); }
+        return highest_bit64( word );
+    }
+
+    const_iterator begin() const { return { this, next( 0 ) }; }
+    const_iterator end() const { return { this, NO_EVENT_TYPE }; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // true if every event type of subpattern belongs to this pattern
+    bool includes(const Pattern& subpattern) const {
+        if ( subpattern.word & ~word ) { return false; }
+        if ( subpattern.words.size() > words.size() ) { return false; }
+        for ( size_t i = 0; i < subpattern.words.size(); ++i ) {
+            if ( subpattern.words[i] & ~words[i] ) { return false; }
+        }
+        return true;
+    }
+
+    Pattern without(EventType event_type) const {
+        Pattern pattern( *this );
+        pattern.erase( event_type );
+        return pattern;
+    }
+
+    Pattern operator|(const Pattern& other) const {
+        Pattern pattern( words.size() >= other.words.size() ? *this : other );
+        const Pattern& smaller = words.size() >= other.words.size() ? other : *this;
+        pattern.word |= smaller.word;
+        for ( size_t i = 0; i < smaller.words.size(); ++i ) { pattern.words[i] |= smaller.words[i]; }
+        return pattern;
+    }
+
+    bool operator==(const Pattern& other) const { return word == other.word && words == other.words; }
+    bool operator!=(const Pattern& other) const { return !(*this == other); }
+
+    // patterns are ordered as their sorted sequences of event types are ordered lexicographically (i.e. like std::set<EventType>)
+    bool operator<(const Pattern& other) const;
+};
+
+std::ostream& operator<<(std::ostream&, const Pattern&);
+
+// the patterns as sets of event type names, ordered as the names are, to print them
+std::set<std::set<std::string>> pattern_names(const EventTypeDictionary&, const std::set<Pattern>&);
+
+
+namespace std {
+    template<>
+    struct hash<Pattern> {
+        size_t operator()(const Pattern& pattern) const {
+            uint64_t h = pattern.word * 0x9E3779B97F4A7C15ull;
+            for ( const uint64_t w : pattern.words ) { h = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ull + w; }
+            return (size_t) (h ^ (h >> 32));
+        }
+    };
+}
+
+
+#endif  // PATTERN_HPP
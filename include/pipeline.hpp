@@ -0,0 +1,25 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "algorithm.hpp"
+#include "dataset.hpp"
+#include "distances.hpp"
+#include "object.hpp"
+
+
+// read a dataset file as construct_dataset does (keeping only the objects of the window), overlapping reading with mining: whenever
+// the file moves on to the next time slot, the objects of the previous one are handed to one of thread_count threads, which computes
+// the tables of the time slot for mine_closed_mdcops while the file is still being read
+// this needs the lines of the file to be sorted by time slot: if they are not (or the file is a binary dataset file, or the window
+// starts after the last time slot) false is returned, leaving dataset and tables untouched, and the file should be read by
+// construct_dataset instead
+bool construct_dataset_pipelined(const std::string& dataset_file_path, unsigned thread_count, std::pair<TimeSlot, unsigned> window,
+                                 std::shared_ptr<INeighborRelation>, Dataset& dataset, std::map<TimeSlot, TimeSlotTables>& tables);
+
+
+#endif  // PIPELINE_HPP
@@ -0,0 +1,39 @@
+#ifndef PREVALENCE_CACHE_HPP
+#define PREVALENCE_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dataset.hpp"
+#include "object.hpp"
+#include "pattern.hpp"
+
+
+struct PrevalenceCache {
+    // a directory of files keeping what SlidingWindowMiner finds in time slots across runs: the partecipating object counts of the
+    // patterns evaluated in a time slot only depend on its objects, the names of the event types and the neighbor relation (not on
+    // p, time or the window), so each time slot has a file named after a hash of them
+    // counts are kept instead of partecipation indexes, as the denominators of partecipation ratios depend on the window
+    const std::string directory_path;
+    const std::string distance;
+    const float dt;
+    
+    size_t hit_count, miss_count;  // time slots
+    size_t read_byte_count, written_byte_count;
+    
+    // the directory is created if missing
+    PrevalenceCache(const std::string& directory_path, const std::string& distance, float dt);
+    
+    uint64_t key(const Dataset&, TimeSlot) const;
+    
+    // false if the cache has no file for the key, or a damaged one
+    bool load(uint64_t key, std::map<Pattern, std::vector<size_t>>& partecipating_object_counts);
+    // false if the file couldn't be written
+    bool store(uint64_t key, const std::map<Pattern, std::vector<size_t>>& partecipating_object_counts);
+};
+
+
+#endif  // PREVALENCE_CACHE_HPP
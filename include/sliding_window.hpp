@@ -0,0 +1,93 @@
+#ifndef SLIDING_WINDOW_HPP
+#define SLIDING_WINDOW_HPP
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "algorithm.hpp"
+#include "dataset.hpp"
+#include "distances.hpp"
+#include "neighbor_graph.hpp"
+#include "object.hpp"
+#include "pattern.hpp"
+#include "prevalence_cache.hpp"
+#include "table_instance.hpp"
+#include "thread_pool.hpp"
+
+
+struct SlidingWindowMiner {
+    // mines closed mdcops in a window of time slots which slides over a dataset, giving the results of mine_closed_mdcops for each
+    // window: what is found about a pattern in a time slot only depends on the time slot, so it is kept for as long as the time slot
+    // is in the window, and sliding the window only evaluates the time slots (and the patterns of the old time slots) it didn't
+    // evaluate before; time prevalence and closedness, which depend on the whole window, are found again from the kept data
+    struct TimeSlotState {
+        std::shared_ptr<NeighborGraph> graph;  // built when first needed
+        // the partecipating object counts of each pattern evaluated in the time slot, from which its partecipation index is found
+        // with the denominators of any window
+        std::map<Pattern, std::vector<size_t>> partecipating_object_counts;
+        // the same, for the neighbor relations with a smaller threshold than the one of the miner, by their max_separation
+        std::map<float, std::map<Pattern, std::vector<size_t>>> partecipating_object_counts_by_max_separation;
+        // the instances of the patterns which were spatial prevalent in the time slot, which the next windows may extend; the
+        // others are dropped, and found again from the instances of their subpatterns if ever needed
+        std::map<Pattern, TableInstance> tables;
+        size_t join_count;  // the joins done for the time slot by the current call to mine
+        
+        bool cache_looked_up;
+        uint64_t cache_key;
+        size_t cached_pattern_count;  // the patterns of partecipating_object_counts which the cache has
+        
+        TimeSlotState() : join_count( 0 ), cache_looked_up( false ), cache_key( 0 ), cached_pattern_count( 0 ) {}
+    };
+    
+    const Dataset& st;
+    const std::shared_ptr<INeighborRelation> r;
+    const float p, time;
+    const unsigned thread_count;
+    // if set before mining, instances keep their diameters, so that windows can also be mined for neighbor relations with smaller
+    // thresholds than r (see mine)
+    bool record_diameters;
+    std::map<TimeSlot, TimeSlotState> time_slots;  // of the current window
+    size_t join_count;  // the joins done by the last call to mine
+    // if set, the time slots entering the window start from what the cache has about them, and the cache is updated with what was
+    // found after each window
+    std::shared_ptr<PrevalenceCache> cache;
+    
+    SlidingWindowMiner(const Dataset&, const std::shared_ptr<INeighborRelation>, const float p, const float time,
+                       const unsigned thread_count = 1);
+    
+    // start time slots from tables computed in advance (see construct_dataset_pipelined)
+    void add_time_slot_tables(std::map<TimeSlot, TimeSlotTables>);
+    
+    // move the window, dropping the time slots which left it, and mine it with the given denominators for partecipation ratios
+    std::map<size_t, std::set<Pattern>> mine(const std::pair<TimeSlot, unsigned> window, const std::vector<size_t>& object_count_by_event_type);
+    // as above, once for each pair of thresholds (p, time) instead of the ones of the miner, sharing everything found in time slots
+    std::vector<std::map<size_t, std::set<Pattern>>> mine(const std::pair<TimeSlot, unsigned> window,
+                                                          const std::vector<size_t>& object_count_by_event_type,
+                                                          const std::vector<std::pair<float, float>>& thresholds);
+    // as above, also once for each neighbor relation, which must be of the same kind as r with a smaller or equal threshold (unless
+    // it is r, record_diameters must be set): the results of the j-th thresholds with the i-th relation are the
+    // (i*thresholds.size() + j)-th
+    std::vector<std::map<size_t, std::set<Pattern>>> mine(const std::pair<TimeSlot, unsigned> window,
+                                                          const std::vector<size_t>& object_count_by_event_type,
+                                                          const std::vector<std::pair<float, float>>& thresholds,
+                                                          const std::vector<std::shared_ptr<INeighborRelation>>& relations);
+    // mine the window (whose time slots must be ready) with the given thresholds and the instances whose diameter is not greater than
+    // max_separation, adding the patterns that the next windows may
+    // extend to extendable_by_time_slot
+    std::map<size_t, std::set<Pattern>> mine(const std::pair<TimeSlot, unsigned> window, const std::vector<size_t>& object_count_by_event_type,
+                                             const float p, const float time, const float max_separation, ThreadPool&,
+                                             std::map<TimeSlot, std::set<Pattern>>& extendable_by_time_slot);
+    
+    // the instances of a pattern in a time slot of the window, and their partecipating object counts
+    const TableInstance& table(TimeSlot, const Pattern&);
+    const std::vector<size_t>& partecipating_object_counts(TimeSlot, const Pattern&);
+    // the partecipating object counts of the instances whose diameter is not greater than max_separation
+    const std::vector<size_t>& partecipating_object_counts(TimeSlot, const Pattern&, const float max_separation);
+};
+
+
+#endif  // SLIDING_WINDOW_HPP
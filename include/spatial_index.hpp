@@ -0,0 +1,246 @@
+#ifndef SPATIAL_INDEX_HPP
+#define SPATIAL_INDEX_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "distances.hpp"
+#include "object.hpp"
+#include "object_store.hpp"
+
+
+struct ISpatialIndex {
+    virtual ~ISpatialIndex() {}
+
+    // append to the given vector the objects of the given event type which are neighbors of the given object
+    virtual void neighbors(ObjectIndex, EventType, std::vector<ObjectIndex>&) = 0;
+};
+
+
+
+struct GridIndex : public ISpatialIndex {
+    // uniform grid over the plane: two neighbor objects are always in the same cell or in adjacent cells
+    const ObjectStore& objects;
+    const double cell_size;
+    const std::shared_ptr<INeighborRelation> r;
+    struct Cell {
+        // the objects of a cell, with a copy of their coordinates so that they can be tested a block at a time
+        std::vector<ObjectIndex> objects;
+        std::vector<float> x, y;
+    };
+    std::map<EventType, std::unordered_map<uint64_t, Cell>> cells_by_event_type;
+    
+    GridIndex(const ObjectStore&, const ObjectRange, float, const std::shared_ptr<INeighborRelation>);
+    
+    virtual void neighbors(ObjectIndex, EventType, std::vector<ObjectIndex>&);
+    // as above, testing the objects of the nearby cells with the given kernel of r (see VirtualNeighborRelation)
+    template<typename Kernel>
+    void neighbors(ObjectIndex, EventType, const Kernel&, std::vector<ObjectIndex>&) const;
+    // the same for euclidean distance, testing the objects of each cell a block at a time (see neighbor_kernels.hpp)
+    void neighbors(ObjectIndex, EventType, const EuclideanDistance::Kernel&, std::vector<ObjectIndex>&) const;
+};
+
+
+inline int64_t cell_coordinate(float coordinate, double cell_size) {
+    // clamp so that the conversion is always defined, far away cells only need to stay far away
+    const double c = std::floor( coordinate/cell_size );
+    return (int64_t) std::max( -4e18, std::min( 4e18, c ) );
+}
+
+inline uint64_t cell_key(int64_t cx, int64_t cy) {
+    // the key wraps around every 2^32 cells: unrelated cells may share a key (their objects are just tested in vain),
+    // but cells adjacent on the grid always have adjacent keys
+    return ((uint64_t) (uint32_t) cx << 32) | (uint32_t) cy;
+}
+
+template<typename Kernel>
+void GridIndex::neighbors(ObjectIndex object, EventType event_type, const Kernel& kernel, std::vector<ObjectIndex>& result) const {
+    const auto i = cells_by_event_type.find( event_type );
+    if ( i == cells_by_event_type.end() ) { return; }
+    const auto& cells = (*i).second;
+    
+    const int64_t cx = cell_coordinate( objects.x[object], cell_size );
+    const int64_t cy = cell_coordinate( objects.y[object], cell_size );
+    for ( int64_t dx = -1; dx <= 1; ++dx ) {
+        for ( int64_t dy = -1; dy <= 1; ++dy ) {
+            const auto j = cells.find( cell_key( cx+dx, cy+dy ) );
+            if ( j == cells.end() ) { continue; }
+            
+            for ( const ObjectIndex candidate : (*j).second.objects ) {
+                if ( kernel.neighbors( object, candidate ) ) { result.push_back( candidate ); }
+            }
+        }
+    }
+}
+
+
+
+struct KDTreeIndex : public ISpatialIndex {
+    // static k-d tree over the plane for each event type, bulk loaded by splitting the objects at the median of the wider side of
+    // their bounding box: unlike the cells of a grid, its leaves hold about the same number of objects however clustered they are
+    const ObjectStore& objects;
+    const float squared_reach;  // subtrees whose bounding box is farther than this squared distance hold no neighbors
+    const std::shared_ptr<INeighborRelation> r;
+    struct Node {
+        // the objects of a subtree are objects[first..last) of its tree; the left child of an inner node follows it, the right
+        // one is nodes[right]
+        float min_x, min_y, max_x, max_y;
+        uint32_t first, last;
+        uint32_t right;
+    };
+    struct Tree {
+        std::vector<Node> nodes;
+        // the objects in the order of the leaves, with a copy of their coordinates so that leaves can be tested a block at a time
+        std::vector<ObjectIndex> objects;
+        std::vector<float> x, y;
+    };
+    std::map<EventType, Tree> trees_by_event_type;
+    
+    static const unsigned LEAF_SIZE = 32;
+    
+    KDTreeIndex(const ObjectStore&, const ObjectRange, float, const std::shared_ptr<INeighborRelation>);
+    
+    virtual void neighbors(ObjectIndex, EventType, std::vector<ObjectIndex>&);
+    // as above, testing the objects of the nearby leaves with the given kernel of r (see VirtualNeighborRelation)
+    template<typename Kernel>
+    void neighbors(ObjectIndex, EventType, const Kernel&, std::vector<ObjectIndex>&) const;
+    // the same for euclidean distance, testing the objects of each leaf a block at a time (see neighbor_kernels.hpp)
+    void neighbors(ObjectIndex, EventType, const EuclideanDistance::Kernel&, std::vector<ObjectIndex>&) const;
+    
+    // call visit( tree, leaf ) for the leaves of the tree of event_type which may hold neighbors of (x, y)
+    template<typename Visitor>
+    void visit_leaves(float x, float y, EventType event_type, Visitor visit) const;
+};
+
+
+template<typename Visitor>
+void KDTreeIndex::visit_leaves(float x, float y, EventType event_type, Visitor visit) const {
+    const auto i = trees_by_event_type.find( event_type );
+    if ( i == trees_by_event_type.end() ) { return; }
+    const Tree& tree = (*i).second;
+    
+    // the tree is balanced, so its depth is at most 32
+    uint32_t stack[64];
+    size_t stack_size = 0;
+    stack[stack_size++] = 0;
+    while ( stack_size > 0 ) {
+        const uint32_t n = stack[--stack_size];
+        const Node& node = tree.nodes[n];
+        const float dx = std::max( std::max( node.min_x - x, x - node.max_x ), 0.f );
+        const float dy = std::max( std::max( node.min_y - y, y - node.max_y ), 0.f );
+        if ( dx*dx + dy*dy > squared_reach ) { continue; }
+        
+        if ( node.right == 0 ) { visit( tree, node ); }
+        else {
+            stack[stack_size++] = node.right;
+            stack[stack_size++] = n+1;
+        }
+    }
+}
+
+template<typename Kernel>
+void KDTreeIndex::neighbors(ObjectIndex object, EventType event_type, const Kernel& kernel, std::vector<ObjectIndex>& result) const {
+    visit_leaves( objects.x[object], objects.y[object], event_type, [&](const Tree& tree, const Node& leaf) {
+        for ( uint32_t k = leaf.first; k < leaf.last; ++k ) {
+            if ( kernel.neighbors( object, tree.objects[k] ) ) { result.push_back( tree.objects[k] ); }
+        }
+    } );
+}
+
+
+struct GeodesicCellIndex : public ISpatialIndex {
+    // cells of the sphere for the latlon distances: bands of latitude as high as the greatest difference of latitude of two
+    // neighbors, each split into as many cells of longitude as its greatest window of longitudes of neighbors fits (see
+    // LatLonDistance), so that cells span about dt both ways at any latitude; the neighbors of an object are in its band or in the
+    // adjacent ones, in the cells its window of longitudes overlaps, taken around the antimeridian, or in every cell of a band the
+    // window covers, as close to the poles
+    const ObjectStore& objects;
+    const ObjectRange range;
+    const LatLonDistance box;  // the band and windows of longitudes of dt km
+    const std::shared_ptr<INeighborRelation> r;
+    std::vector<float> longitude_windows;  // of the objects of range
+    std::unordered_map<uint32_t, uint32_t> cell_counts_by_band;  // of the bands holding objects
+    std::map<EventType, std::unordered_map<uint64_t, std::vector<ObjectIndex>>> cells_by_event_type;
+    
+    GeodesicCellIndex(const ObjectStore&, const ObjectRange, float, const std::shared_ptr<INeighborRelation>);
+    
+    virtual void neighbors(ObjectIndex, EventType, std::vector<ObjectIndex>&);
+    // as above, testing the objects of the nearby cells with the given kernel of r (see VirtualNeighborRelation)
+    template<typename Kernel>
+    void neighbors(ObjectIndex, EventType, const Kernel&, std::vector<ObjectIndex>&) const;
+    
+    // call visit( key ) for the keys of the cells which may hold neighbors of an object of range
+    template<typename Visitor>
+    void visit_cells(ObjectIndex, Visitor visit) const;
+    // the fraction of the pairs of objects of range which the index tests, i.e. which are in nearby cells
+    double candidate_fraction() const;
+    
+    uint32_t band(float lat) const;
+    // the cells of a band of cell_count cells are columns of longitudes, the column of longitude 0 being cell 0 and the columns
+    // 360 degrees apart being the same cell
+    static int64_t column(double lon, uint32_t cell_count) { return (int64_t) std::floor( lon * cell_count / 360 ); }
+    static uint32_t cell(int64_t column, uint32_t cell_count) { return (uint32_t) (((column % cell_count) + cell_count) % cell_count); }
+    static uint64_t cell_key(uint32_t band, uint32_t cell) { return ((uint64_t) band << 32) | cell; }
+};
+
+
+template<typename Visitor>
+void GeodesicCellIndex::visit_cells(ObjectIndex object, Visitor visit) const {
+    const float window = longitude_windows[object-range.first];
+    const uint32_t band1 = band( objects.x[object] );
+    for ( uint32_t band2 = band1 > 0 ? band1-1 : 0; band2 <= band1+1; ++band2 ) {
+        const auto i = cell_counts_by_band.find( band2 );
+        if ( i == cell_counts_by_band.end() ) { continue; }
+        const uint32_t cell_count = (*i).second;
+        
+        // the cells from the one of the westmost longitude of the window to the one of the eastmost, or all of them
+        uint32_t first_cell = 0, window_cell_count = cell_count;
+        if ( window < 180 ) {
+            const int64_t west = column( objects.y[object] - window, cell_count );
+            const int64_t east = column( objects.y[object] + window, cell_count );
+            first_cell = cell( west, cell_count );
+            window_cell_count = (uint32_t) std::min<int64_t>( east-west+1, cell_count );
+        }
+        for ( uint32_t k = 0; k < window_cell_count; ++k ) { visit( cell_key( band2, (first_cell+k) % cell_count ) ); }
+    }
+}
+
+template<typename Kernel>
+void GeodesicCellIndex::neighbors(ObjectIndex object, EventType event_type, const Kernel& kernel, std::vector<ObjectIndex>& result) const {
+    const auto i = cells_by_event_type.find( event_type );
+    if ( i == cells_by_event_type.end() ) { return; }
+    const auto& cells = (*i).second;
+    
+    visit_cells( object, [&](uint64_t key) {
+        const auto j = cells.find( key );
+        if ( j == cells.end() ) { return; }
+        for ( const ObjectIndex candidate : (*j).second ) {
+            if ( kernel.neighbors( object, candidate ) ) { result.push_back( candidate ); }
+        }
+    } );
+}
+
+
+// the kind of index construct_spatial_index builds when the relation allows one: "grid", "tree", or "auto" (the default) to pick
+// for each time slot the one suited to how its objects are distributed (see tree_suits); not to be changed while other threads
+// construct indexes
+const std::string& spatial_index_kind();
+bool set_spatial_index_kind(const std::string&);
+
+// true if a k-d tree finds the neighbors within dt of the given objects faster than a grid, i.e. unless the objects fill the cells
+// of a grid evenly and densely
+bool tree_suits(const ObjectStore&, const ObjectRange, float dt);
+
+// construct the index of the given objects best suited to the neighbor relation, or nullptr if neighbors can only be found by testing
+// all pairs
+std::shared_ptr<ISpatialIndex> construct_spatial_index(const ObjectStore&, const ObjectRange, const std::shared_ptr<INeighborRelation>);
+
+
+#endif  // SPATIAL_INDEX_HPP
@@ -0,0 +1,60 @@
+#ifndef TABLE_INSTANCE_HPP
+#define TABLE_INSTANCE_HPP
+
+#include <cstddef>
+#include <initializer_list>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "object_store.hpp"
+
+
+struct TableInstance {
+    // all the instances of a pattern of size k, stored as flat arrays of object indexes:
+    //  - instances are grouped by their first common k-1 objects (the prefix), and groups are sorted by prefix
+    //  - the prefix of group i is prefixes[i*(k-1)..(i+1)*(k-1))
+    //  - the k-th objects of the instances of group i are last_objects[offsets[i]..offsets[i+1]), sorted
+    // e.g
+    // pattern: { a, b, c, d }
+    // prefix: a1, b1, c1
+    // last objects: d1, d2, d5
+    // the instances of this group are: { a1, b1, c1, d1 }, { a1, b1, c1, d2 }, { a1, b1, c1, d5 }
+    // tables are built append-only, one group at a time, in prefix order
+    size_t prefix_size;
+    std::vector<ObjectIndex> prefixes;
+    std::vector<size_t> offsets;
+    std::vector<ObjectIndex> last_objects;
+    // if the table was built from a neighbor graph with separations, the diameter of each instance (the greatest separation between
+    // two of its objects), parallel to last_objects: the instances of the pattern for a neighbor relation with a smaller threshold
+    // are the ones whose diameter is not greater than its max_separation
+    std::vector<float> diameters;
+
+    TableInstance() : TableInstance( 0 ) {}
+    explicit TableInstance(size_t prefix_size) : prefix_size( prefix_size ), offsets{ 0 } {}
+    // a table from its groups, given as (prefix, last objects) pairs sorted by prefix
+    TableInstance(std::initializer_list<std::pair<std::vector<ObjectIndex>, std::vector<ObjectIndex>>>);
+
+    size_t group_count() const { return offsets.size()-1; }
+    bool empty() const { return last_objects.empty(); }
+
+    const ObjectIndex* prefix(size_t group) const { return prefixes.data() + group*prefix_size; }
+    const ObjectIndex* last_objects_begin(size_t group) const { return last_objects.data() + offsets[group]; }
+    const ObjectIndex* last_objects_end(size_t group) const { return last_objects.data() + offsets[group+1]; }
+
+    // close the group with the given prefix, whose last objects have just been appended to last_objects (if there are none, the
+    // group is not added)
+    void close_group(const ObjectIndex* prefix) {
+        if ( last_objects.size() == offsets.back() ) { return; }
+        prefixes.insert( prefixes.end(), prefix, prefix + prefix_size );
+        offsets.push_back( last_objects.size() );
+    }
+
+    bool operator==(const TableInstance&) const;
+    bool operator!=(const TableInstance& other) const { return !(*this == other); }
+};
+
+std::ostream& operator<<(std::ostream&, const TableInstance&);
+
+
+#endif  // TABLE_INSTANCE_HPP
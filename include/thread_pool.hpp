@@ -0,0 +1,75 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+struct TaskGroup {
+    // the tasks run by a pool that someone is waiting for
+    std::atomic<size_t> pending;
+    std::mutex exception_mutex;
+    std::exception_ptr exception;  // the first exception thrown by one of the tasks
+
+    TaskGroup() : pending( 0 ) {}
+};
+
+
+struct ThreadPool {
+    // work-stealing pool: each worker pushes the tasks it spawns to its own deque and runs them newest first, and when it has none it
+    // steals the oldest task of another worker, which is usually the biggest piece of work left; threads waiting for a group of tasks
+    // run tasks meanwhile, so tasks can spawn and wait for other tasks
+    // a pool of a single thread has no workers and runs tasks as soon as they are spawned
+    struct Task {
+        TaskGroup* group;
+        std::function<void()> f;
+    };
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    const unsigned thread_count;
+    // the deques of the threads of the pool, plus the one shared by all the other threads (the first one)
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::atomic<size_t> queued_task_count;
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_condition;
+    bool stopping;
+
+    // thread_count counts the calling thread too, which works while waiting for its tasks
+    explicit ThreadPool(unsigned thread_count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void run(TaskGroup&, std::function<void()>);
+    // run tasks until all the tasks of the group are done, then rethrow the first exception they threw
+    void wait(TaskGroup&);
+
+    // true if no task is waiting to be run, i.e. splitting work in more tasks could keep more threads busy
+    bool needs_tasks() const { return !threads.empty() && queued_task_count == 0; }
+
+    // run a task of the given worker, or steal one from the other workers; false if there are none
+    bool run_one(size_t worker);
+    // the worker of the calling thread
+    size_t current_worker() const;
+};
+
+
+// call f( i ) for each i in 0..count as tasks of the given pool, and wait for them
+void parallel_for(ThreadPool&, size_t count, const std::function<void(size_t)>& f);
+
+
+#endif  // THREAD_POOL_HPP
@@ -1,9 +1,14 @@
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
 #include <limits>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <mutex>
 #include <set>
 #include <utility>
 #include <vector>
@@ -12,7 +17,12 @@
 
 #include "algorithm.hpp"
 #include "dataset.hpp"
+#include "neighbor_graph.hpp"
 #include "object.hpp"
+#include "object_store.hpp"
+#include "pattern.hpp"
+#include "table_instance.hpp"
+#include "thread_pool.hpp"
 
 
 #ifdef DEBUG
@@ -31,27 +41,19 @@ bool exist_all_subsets(const Pattern& superset_pattern, const std::set<Pattern>&
     
     if ( superset_pattern.size() == 1 ) { return true; }
     
-    const size_t possible_subset_count = superset_pattern.size();
-    
-    unsigned subset_count = 0;
-    for ( const Pattern& pattern : patterns ) {
-        if ( std::includes( superset_pattern.cbegin(), superset_pattern.cend(), pattern.cbegin(), pattern.cend() ) ) {
-            // pattern is a subset of superset_pattern
-            ++subset_count;
-        }
+    // each subset is superset_pattern without one of its event types
+    for ( const EventType event_type : superset_pattern ) {
+        if ( !patterns.count( superset_pattern.without( event_type ) ) ) { return false; }
     }
-    
-    assert( subset_count <= possible_subset_count );
-    return subset_count == possible_subset_count;
+    return true;
 }
 bool exist_all_subsets(const Pattern& superset_pattern, const std::map<Pattern, SubPatterns>& patterns_with_subpatterns) {
-    std::set<Pattern> patterns;
-    for ( const auto& pair : patterns_with_subpatterns ) {
-        const Pattern& pattern = pair.first;
-        
-        patterns.insert( pattern );
+    if ( superset_pattern.size() == 1 ) { return true; }
+    
+    for ( const EventType event_type : superset_pattern ) {
+        if ( !patterns_with_subpatterns.count( superset_pattern.without( event_type ) ) ) { return false; }
     }
-    return exist_all_subsets( superset_pattern, patterns );
+    return true;
 }
 
 std::map<Pattern, SubPatterns> apriori_gen(const std::set<Pattern>& patterns) {
@@ -64,44 +66,21 @@ std::map<Pattern, SubPatterns> apriori_gen(const std::set<Pattern>& patterns) {
     // join step
     for ( auto i = patterns.cbegin(); i != patterns.cend(); ++i ) {
         const Pattern& pattern1 = *i;
+        const EventType last_event_type1 = pattern1.last();
+        const Pattern first_event_types1 = pattern1.without( last_event_type1 );
         
-        for ( auto j = i; j != patterns.cend(); ++j ) {
+        // patterns are sorted like sequences of event types, so the patterns whose first k-1 event types are identical to the ones
+        // of pattern1 (and whose last event type is greater than the last one of pattern1) immediately follow pattern1
+        for ( auto j = std::next( i ); j != patterns.cend(); ++j ) {
             const Pattern& pattern2 = *j;
             assert( pattern1.size() == pattern2.size() );
             
-            // check if the first k-1 event types of pattern1 and pattern2 are identical
-            
-            assert( pattern1.size() == pattern2.size() );
-            const size_t k = pattern1.size();
+            const EventType last_event_type2 = pattern2.last();
+            if ( pattern2.without( last_event_type2 ) != first_event_types1 ) { break; }
+            assert( last_event_type1 < last_event_type2 );
             
-            bool first_k_event_types_identical = true;
-            auto m = pattern1.cbegin(), n = pattern2.cbegin();
-            for ( int o = 0; o < k-1; ++o ) {
-                const EventType event_type1 = *m;
-                const EventType event_type2 = *n;
-                
-                if ( event_type1 != event_type2 ) {
-                    first_k_event_types_identical = false;
-                    break;
-                }
-                
-                ++m;
-                ++n;
-            }
-            if ( first_k_event_types_identical ) {
-                const EventType last_event_type1 = *m;
-                const EventType last_event_type2 = *n;
-                
-                // check if the last event type of pattern1 is less then the last element of pattern2
-                if ( last_event_type1 < last_event_type2 ) {
-                    // join pattern1 and pattern2
-                    Pattern superset_pattern;
-                    std::set_union( pattern1.begin(), pattern1.end(), pattern2.begin(), pattern2.end(),
-                                   std::inserter( superset_pattern, superset_pattern.end() ) );
-                    
-                    superset_patterns.insert( { superset_pattern, { pattern1, pattern2 } } );
-                }
-            }
+            // join pattern1 and pattern2
+            superset_patterns.insert( { pattern1 | pattern2, { pattern1, pattern2 } } );
         }
     }
     
@@ -152,44 +131,142 @@ std::map<TimeSlot, std::map<Pattern, SubPatterns>> gen_candidate_co_occ(const st
 }
 
 
-TableInstance join(const TableInstance& table1, const TableInstance& table2, const std::shared_ptr<INeighborRelation> d) {
-    PRINTLN( SPACES( 20 ) << "-> " << __FUNCTION__ );
-
-    // each table is a map which contains all the instances of a pattern of size k:
-    //  - the key is a set of objects that represent the first common k-1 objects of some instances of the pattern
-    //  - the value is a set of objects which represent the k-nth element of each instance of the pattern
-    // e.g
-    // pattern: { a, b, c, d }
-    // key: { a1, b1, c1 }
-    // values { d1, d2, d5 }
-    // the instances referenced by this key are: { a1, b1, c1, d1 }, { a1, b1, c1, d2 }, { a1, b1, c1, d5 }
-    
-    TableInstance table;
+void join(const TableInstance& table1, const TableInstance& table2, const NeighborGraph& graph, const size_t first, const size_t last,
+          TableInstance& table) {
+    // append to table the instances generated by the last objects first..last of table1 (positions in table1.last_objects)
+    assert( table1.prefix_size == table2.prefix_size );
+    assert( table.prefix_size == table1.prefix_size+1 );
+    if ( first == last ) { return; }
+    
+    // the groups of both tables are ordered by their prefixes, so a single merge pass over table1 and table2 is enough to pair up
+    // the prefixes they have in common: each prefix is compared a constant number of times instead of against every prefix
+    // of the other table
+    
+    const size_t prefix_size = table1.prefix_size;
+    const auto prefix_less = [prefix_size](const ObjectIndex* prefix1, const ObjectIndex* prefix2) {
+        return std::lexicographical_compare( prefix1, prefix1 + prefix_size, prefix2, prefix2 + prefix_size );
+    };
+    std::vector<ObjectIndex> new_prefix( prefix_size+1 );
+    const bool with_diameters = !table1.diameters.empty();
+    assert( !with_diameters || (!graph.separations.empty() || graph.neighbors.empty()) );
+    assert( table2.diameters.size() == (with_diameters ? table2.last_objects.size() : 0) );
+    
+    // the group of table1 of the first last object, and the first group of table2 which is not before it
+    size_t i = std::upper_bound( table1.offsets.cbegin(), table1.offsets.cend(), first ) - table1.offsets.cbegin() - 1;
+    size_t j = 0;
+    for ( size_t count = table2.group_count(); count > 0; ) {
+        const size_t half = count/2;
+        if ( prefix_less( table2.prefix( j+half ), table1.prefix( i ) ) ) { j += half+1; count -= half+1; }
+        else { count = half; }
+    }
     
-    for( const auto& pair1 : table1 ) {
-        const std::set<std::shared_ptr<Object>>& pair1_first_common_objects = pair1.first;
-        const std::set<std::shared_ptr<Object>>& pair1_last_objects = pair1.second;
+    while ( i < table1.group_count() && table1.offsets[i] < last && j < table2.group_count() ) {
+        const ObjectIndex* group1_prefix = table1.prefix( i );
+        const ObjectIndex* group2_prefix = table2.prefix( j );
+        
+        if ( prefix_less( group1_prefix, group2_prefix ) ) { ++i; continue; }
+        if ( prefix_less( group2_prefix, group1_prefix ) ) { ++j; continue; }
         
-        for( const auto& pair2 : table2 ) {
-            const std::set<std::shared_ptr<Object>>& pair2_first_common_objects = pair2.first;
-            const std::set<std::shared_ptr<Object>>& pair2_last_objects = pair2.second;
+        const ObjectIndex* group2_last_objects_begin = table2.last_objects_begin( j );
+        const ObjectIndex* group2_last_objects_end = table2.last_objects_end( j );
+        std::copy( group1_prefix, group1_prefix + prefix_size, new_prefix.begin() );
+        
+        // for each object1, its neighbors in the neighbor graph of the time slot are intersected with the last objects of group2
+        // (both are sorted by index) straight into the last objects of table; the groups of table1 and their last objects are
+        // visited in order, so new groups are always appended to table in prefix order
+        const ObjectIndex* objects1_begin = table1.last_objects.data() + std::max( first, table1.offsets[i] );
+        const ObjectIndex* objects1_end = table1.last_objects.data() + std::min( last, table1.offsets[i+1] );
+        for ( const ObjectIndex* object1 = objects1_begin; object1 != objects1_end; ++object1 ) {
+            const std::pair<const ObjectIndex*, const ObjectIndex*> neighbors = graph.neighbors_of( *object1 );
+            const ObjectIndex* neighbors_begin = std::lower_bound( neighbors.first, neighbors.second, *group2_last_objects_begin );
             
-            if ( pair1_first_common_objects == pair2_first_common_objects ) {
-                // for each possible combinations, check which objects are neighbors
-                for ( const std::shared_ptr<Object>& object1 : pair1_last_objects ) {
-                    std::set<std::shared_ptr<Object>> new_first_common_objects{ pair1_first_common_objects };
-                    new_first_common_objects.insert( object1 );
+            if ( !with_diameters ) {
+                std::set_intersection( neighbors_begin, neighbors.second, group2_last_objects_begin, group2_last_objects_end,
+                                       std::back_inserter( table.last_objects ) );
+            }
+            else {
+                // the pairs of objects of a new instance are the ones of the instances of table1 and table2 it comes from, plus object1
+                // and object2
+                const float diameter1 = table1.diameters[object1 - table1.last_objects.data()];
+                const ObjectIndex* neighbor = neighbors_begin;
+                const ObjectIndex* object2 = group2_last_objects_begin;
+                while ( neighbor != neighbors.second && object2 != group2_last_objects_end ) {
+                    if ( *neighbor < *object2 ) { ++neighbor; continue; }
+                    if ( *object2 < *neighbor ) { ++object2; continue; }
                     
-                    for ( const std::shared_ptr<Object>& object2 : pair2_last_objects ) {
-                        assert( object1->event_type != object2->event_type );
-                        
-                        if ( d->neighbors( object1, object2 ) ) {
-                            table[new_first_common_objects].insert( object2 );
-                        }
-                    }
+                    table.last_objects.push_back( *object2 );
+                    table.diameters.push_back( std::max( { diameter1, table2.diameters[object2 - table2.last_objects.data()],
+                                                           graph.separations[neighbor - graph.neighbors.data()] } ) );
+                    ++neighbor;
+                    ++object2;
                 }
             }
+            
+            new_prefix.back() = *object1;
+            table.close_group( new_prefix.data() );
+        }
+        
+        ++i;
+        ++j;
+    }
+}
+
+TableInstance join(const TableInstance& table1, const TableInstance& table2, const NeighborGraph& graph) {
+    PRINTLN( SPACES( 20 ) << "-> " << __FUNCTION__ );
+
+    // each table contains all the instances of a pattern of size k, grouped by their first common k-1 objects (see TableInstance)
+    
+    TableInstance table( table1.prefix_size+1 );
+    join( table1, table2, graph, 0, table1.last_objects.size(), table );
+    
+    PRINTLN( SPACES( 20 ) << "<- " << __FUNCTION__ );
+    return table;
+}
+
+TableInstance join(const TableInstance& table1, const TableInstance& table2, const NeighborGraph& graph, ThreadPool& pool) {
+    // each last object of table1 generates its own group of instances, so the last objects of table1 can be split in ranges joined
+    // concurrently into partial tables, which are then concatenated in order
+    // a range is joined a few last objects at a time, and whenever the pool has no task waiting to be run the rest of the range is
+    // split in two tasks: ranges are only as small as needed to keep every thread busy, and even a join which started while the
+    // other threads were busy ends up spread over all threads once they run out of work
+    const size_t step_size = 256;
+    if ( pool.thread_count == 1 || table1.last_objects.size() <= 2*step_size ) { return join( table1, table2, graph ); }
+    
+    PRINTLN( SPACES( 20 ) << "-> " << __FUNCTION__ );
+    
+    std::mutex partial_tables_mutex;
+    std::map<size_t, TableInstance> partial_tables;  // by the first last object of their range
+    
+    TaskGroup group;
+    std::function<void(size_t, size_t)> join_range = [&](const size_t first, size_t last) {
+        TableInstance partial_table( table1.prefix_size+1 );
+        for ( size_t next = first; next < last; ) {
+            if ( last-next > 2*step_size && pool.needs_tasks() ) {
+                const size_t middle = next + (last-next)/2;
+                pool.run( group, [&join_range, middle, last]() { join_range( middle, last ); } );
+                last = middle;
+            }
+            
+            const size_t step_last = std::min( last, next+step_size );
+            join( table1, table2, graph, next, step_last, partial_table );
+            next = step_last;
         }
+        
+        std::lock_guard<std::mutex> lock( partial_tables_mutex );
+        partial_tables.emplace( first, std::move( partial_table ) );
+    };
+    pool.run( group, [&join_range, &table1]() { join_range( 0, table1.last_objects.size() ); } );
+    pool.wait( group );
+    
+    TableInstance table( table1.prefix_size+1 );
+    for ( const auto& pair : partial_tables ) {
+        const TableInstance& partial_table = pair.second;
+        
+        const size_t offset = table.last_objects.size();
+        table.prefixes.insert( table.prefixes.end(), partial_table.prefixes.cbegin(), partial_table.prefixes.cend() );
+        table.last_objects.insert( table.last_objects.end(), partial_table.last_objects.cbegin(), partial_table.last_objects.cend() );
+        table.diameters.insert( table.diameters.end(), partial_table.diameters.cbegin(), partial_table.diameters.cend() );
+        for ( size_t group = 1; group < partial_table.offsets.size(); ++group ) { table.offsets.push_back( offset + partial_table.offsets[group] ); }
     }
     
     PRINTLN( SPACES( 20 ) << "<- " << __FUNCTION__ );
@@ -197,80 +274,140 @@ TableInstance join(const TableInstance& table1, const TableInstance& table2, con
 }
 
 std::map<Pattern, TableInstance> gen_co_occ_inst(const std::map<Pattern, SubPatterns>& c, const std::map<Pattern, TableInstance>& prev_t,
-                                                 const std::shared_ptr<INeighborRelation> d) {
+                                                 const NeighborGraph& graph, ThreadPool& pool) {
     PRINTLN( SPACES( 15 ) << "-> " << __FUNCTION__ );
 
     // generate instances of each candidate_pattern by joining the tables of its two subpatterns
     
-    std::map<Pattern, TableInstance> t;
+    // joins only read prev_t, so each one is a task of pool which writes to its own table; tables are moved to t in order once all
+    // the joins are done, so no lock is needed
+    std::vector<std::map<Pattern, SubPatterns>::const_iterator> candidates;
+    for ( auto i = c.cbegin(); i != c.cend(); ++i ) { candidates.push_back( i ); }
     
-    for( const auto& pair : c ) {
-        const Pattern& candidate_pattern = pair.first;
-        
-        const SubPatterns& subpatterns = pair.second;
+    std::vector<TableInstance> tables( candidates.size() );
+    parallel_for( pool, candidates.size(), [&](size_t i) {
+        const SubPatterns& subpatterns = (*candidates[i]).second;
         const TableInstance& subpatterns_table1 = prev_t.at( subpatterns.first );
         const TableInstance& subpatterns_table2 = prev_t.at( subpatterns.second );
-        t[candidate_pattern] = join( subpatterns_table1, subpatterns_table2, d );
+        tables[i] = join( subpatterns_table1, subpatterns_table2, graph, pool );
+    } );
+    
+    std::map<Pattern, TableInstance> t;
+    for ( size_t i = 0; i < candidates.size(); ++i ) {
+        const Pattern& candidate_pattern = (*candidates[i]).first;
+        t.emplace_hint( t.cend(), candidate_pattern, std::move( tables[i] ) );
     }
 
     PRINTLN( SPACES( 15 ) << "<- " << __FUNCTION__ );
     return t;
 }
 
+std::map<Pattern, TableInstance> take_co_occ_inst(const std::map<Pattern, SubPatterns>& c, std::map<Pattern, TableInstance>& precomputed_t) {
+    PRINTLN( SPACES( 15 ) << "-> " << __FUNCTION__ );
+    
+    // move the instances of each candidate_pattern out of the ones found in advance, which lack the patterns without instances
+    std::map<Pattern, TableInstance> t;
+    for ( const auto& pair : c ) {
+        const Pattern& candidate_pattern = pair.first;
+        
+        const auto i = precomputed_t.find( candidate_pattern );
+        if ( i != precomputed_t.end() ) { t.emplace_hint( t.cend(), candidate_pattern, std::move( (*i).second ) ); }
+        else { t.emplace_hint( t.cend(), candidate_pattern, TableInstance( candidate_pattern.size()-1 ) ); }
+    }
+    
+    PRINTLN( SPACES( 15 ) << "<- " << __FUNCTION__ );
+    return t;
+}
 
-std::set<Pattern> find_spatial_prev_co_occ(const std::map<EventType, std::set<std::shared_ptr<Object>>>& objects_by_event_type,
-                                           const std::map<Pattern, TableInstance>& t, float p,
+
+std::vector<size_t> find_partecipating_object_counts(const Pattern& pattern, const TableInstance& table) {
+    // divide objects per object type: the i-th object of each instance has the i-th event type of the pattern; each object of a
+    // prefix appears once in its group, no matter how many instances share it, since only distinct objects are counted
+    const size_t k = pattern.size();
+    assert( table.empty() || table.prefix_size == k-1 );
+    std::vector<std::vector<ObjectIndex>> objects_by_position( k );
+    for ( size_t i = 0; i < k-1; ++i ) {
+        objects_by_position[i].reserve( table.group_count() );
+        for ( size_t group = 0; group < table.group_count(); ++group ) { objects_by_position[i].push_back( table.prefix( group )[i] ); }
+    }
+    objects_by_position[k-1] = table.last_objects;
+    
+    std::vector<size_t> partecipating_object_counts;
+    for ( std::vector<ObjectIndex>& objects : objects_by_position ) {
+        std::sort( objects.begin(), objects.end() );
+        partecipating_object_counts.push_back( std::unique( objects.begin(), objects.end() ) - objects.begin() );
+    }
+    return partecipating_object_counts;
+}
+
+std::vector<size_t> find_partecipating_object_counts(const Pattern& pattern, const TableInstance& table, const float max_diameter) {
+    // as above, skipping the instances which are too wide and the prefixes left without instances
+    const size_t k = pattern.size();
+    assert( table.empty() || table.prefix_size == k-1 );
+    assert( table.diameters.size() == table.last_objects.size() );
+    std::vector<std::vector<ObjectIndex>> objects_by_position( k );
+    for ( size_t group = 0; group < table.group_count(); ++group ) {
+        const size_t last_object_count = objects_by_position[k-1].size();
+        for ( size_t i = table.offsets[group]; i < table.offsets[group+1]; ++i ) {
+            if ( table.diameters[i] <= max_diameter ) { objects_by_position[k-1].push_back( table.last_objects[i] ); }
+        }
+        if ( objects_by_position[k-1].size() == last_object_count ) { continue; }
+        
+        for ( size_t i = 0; i < k-1; ++i ) { objects_by_position[i].push_back( table.prefix( group )[i] ); }
+    }
+    
+    std::vector<size_t> partecipating_object_counts;
+    for ( std::vector<ObjectIndex>& objects : objects_by_position ) {
+        std::sort( objects.begin(), objects.end() );
+        partecipating_object_counts.push_back( std::unique( objects.begin(), objects.end() ) - objects.begin() );
+    }
+    return partecipating_object_counts;
+}
+
+float find_partecipation_index(const std::vector<size_t>& object_count_by_event_type, const Pattern& pattern,
+                               const std::vector<size_t>& partecipating_object_counts) {
+    // compute partecipation ratios
+    std::vector<float> partecipation_ratios;
+    auto event_type = pattern.cbegin();
+    for ( const size_t partecipating_object_count : partecipating_object_counts ) {
+        if ( partecipating_object_count == 0 ) { ++event_type; continue; }
+        
+        float numerator = partecipating_object_count;
+        float denominator = object_count_by_event_type.at( *event_type );
+        assert( numerator > 0 );
+        assert( denominator > 0 );
+        
+        float partecipation_ratio = numerator/denominator;
+        assert( partecipation_ratio >= 0 && partecipation_ratio <= 1 );
+        
+        partecipation_ratios.push_back( partecipation_ratio );
+        ++event_type;
+    }
+    
+    // compute partecipation index (the maximum float if the pattern has no instances)
+    float partecipation_index = std::numeric_limits<float>::max();
+    for ( const float partecipation_ratio : partecipation_ratios ) {
+        if ( partecipation_ratio < partecipation_index ) { partecipation_index = partecipation_ratio; }
+    }
+    return partecipation_index;
+}
+float find_partecipation_index(const std::vector<size_t>& object_count_by_event_type, const Pattern& pattern, const TableInstance& table) {
+    return find_partecipation_index( object_count_by_event_type, pattern, find_partecipating_object_counts( pattern, table ) );
+}
+
+std::set<Pattern> find_spatial_prev_co_occ(const std::map<Pattern, float>& partecipation_indexes, float p,
                                            std::map<Pattern, std::vector<float>>& spatial_indexes_by_pattern) {
     PRINTLN( SPACES( 15 ) << "-> " << __FUNCTION__ );
     assert( p > 0 && p <=1 );
     
     std::set<Pattern> sp;
     
-    for ( const auto& pair : t ) {
+    for ( const auto& pair : partecipation_indexes ) {
         // for each pattern
-        const TableInstance& table = pair.second;
-        
-        // divide objects per object type
-        std::map<EventType, std::set<ObjectId>> ids_by_event_type;
-        for ( const auto& pair : table ) {
-            const std::set<std::shared_ptr<Object>>& instances_common_objects = pair.first;
-            
-            for ( const std::shared_ptr<Object>& object : instances_common_objects ) {
-                ids_by_event_type[object->event_type].insert( object->id );
-            }
-
-            const std::set<std::shared_ptr<Object>>& instances_last_objects = pair.second;
-            for ( const std::shared_ptr<Object>& object : instances_last_objects ) {
-                ids_by_event_type[object->event_type].insert( object->id );
-            }
-        }
-        
-        // compute partecipation ratios
-        std::map<EventType, float> partecipation_ratio_by_event_type;
-        for ( const auto& pair2 : ids_by_event_type ) {
-            const EventType& event_type = pair2.first;
-            
-            float numerator = pair2.second.size();
-            float denominator = objects_by_event_type.at( event_type ).size();
-            assert( numerator > 0 );
-            assert( denominator > 0 );
-            
-            float partecipation_ratio = numerator/denominator;
-            assert( partecipation_ratio >= 0 && partecipation_ratio <= 1 );
-            
-            partecipation_ratio_by_event_type[event_type] = partecipation_ratio;
-        }
-        
-        // compute partecipation index
-        float partecipation_index = std::numeric_limits<float>::max();
-        for ( const auto& pair2 : partecipation_ratio_by_event_type ) {
-            const float partecipation_ratio = pair2.second;
-            
-            if ( partecipation_ratio < partecipation_index ) { partecipation_index = partecipation_ratio; }
-        }
+        const Pattern& pattern = pair.first;
+        const float partecipation_index = pair.second;
         
         // check if partecipation index is above the threshold
-        const Pattern& pattern = pair.first;
         if ( partecipation_index != std::numeric_limits<float>::max() && partecipation_index >= p ) { sp.insert( pattern ); }
         PRINTLN( SPACES( 20 ) << pattern << ", P.I. " << partecipation_index );
         
@@ -281,6 +418,16 @@ std::set<Pattern> find_spatial_prev_co_occ(const std::map<EventType, std::set<st
     PRINTLN( SPACES( 15 ) << "<- " << __FUNCTION__ << ": " << sp );
     return sp;
 }
+std::set<Pattern> find_spatial_prev_co_occ(const std::vector<size_t>& object_count_by_event_type,
+                                           const std::map<Pattern, TableInstance>& t, float p,
+                                           std::map<Pattern, std::vector<float>>& spatial_indexes_by_pattern) {
+    std::map<Pattern, float> partecipation_indexes;
+    for ( const auto& pair : t ) {
+        partecipation_indexes.emplace_hint( partecipation_indexes.cend(), pair.first,
+                                            find_partecipation_index( object_count_by_event_type, pair.first, pair.second ) );
+    }
+    return find_spatial_prev_co_occ( partecipation_indexes, p, spatial_indexes_by_pattern );
+}
 
 
 void find_time_index(std::map<Pattern, float>& tp, const std::set<Pattern>& sp, const unsigned time_slot_count) {
@@ -302,6 +449,7 @@ std::set<Pattern> find_time_prev_co_occ(std::map<Pattern, float>& tp, const floa
     assert( time_slot_count > time_slot );
     
     // a (spatial prevalent) pattern is time prevalent if its time index is greater or equal than the threshold time
+    // (time_slot is the position of the current time slot among the time_slot_count time slots of the window)
 
     std::set<Pattern> mdp;
     
@@ -352,7 +500,7 @@ void prune_non_closed_subsets(std::map<size_t, std::set<Pattern>>& cmdp, const P
             const Pattern& subpattern = *i;
             
             // check if subpattern has identical partecipation indexes of pattern
-            if ( std::includes( pattern.cbegin(), pattern.cend(), subpattern.cbegin(), subpattern.cend() ) ) {
+            if ( pattern.includes( subpattern ) ) {
                 const std::vector<float>& pattern_partecipation_indexes = spatial_indexes_by_pattern.at( pattern );
                 const std::vector<float>& subpattern_partecipation_indexes = spatial_indexes_by_pattern.at( subpattern );
 
@@ -375,31 +523,33 @@ void prune_non_closed_subsets(std::map<size_t, std::set<Pattern>>& cmdp, const P
 std::map<size_t, std::set<Pattern>> mine_closed_mdcops(const std::set<EventType>& e, const Dataset& st,
                                                        const std::pair<TimeSlot, unsigned> tf,
                                                        const std::shared_ptr<INeighborRelation> r,
-                                                       const float p, const float time) {
+                                                       const float p, const float time, const unsigned thread_count,
+                                                       std::map<TimeSlot, TimeSlotTables> precomputed) {
     TimeSlot first_time_slot = tf.first;
     assert( first_time_slot >= 0 );
     unsigned time_slot_count = tf.second;
     assert( time_slot_count > 0 );
-    assert( first_time_slot + time_slot_count <= st.objects_by_time_slot.size() );
+    assert( first_time_slot + time_slot_count <= st.time_slot_count );
 
     assert( r );
     
     assert( p > 0 && p <= 1 );
     assert( time > 0 && time <= 1 );
+    assert( thread_count > 0 );
     
     // initialization
     size_t k = 1;  // current pattern size
     
     std::map<size_t, std::set<Pattern>> cmdp;  // closed mdcops
     // for each event type of the dataset construct a size-1 mdcop
-    for ( const EventType& event_type : e ) {
+    for ( const EventType event_type : e ) {
         const Pattern pattern{ event_type };
         
         cmdp[k].insert( pattern );
     }
     
     std::map<size_t, std::map<TimeSlot, std::map<Pattern, SubPatterns>>> c;  // candidate patterns grouped by size and time slot
-    for ( const EventType& event_type : e ) {
+    for ( const EventType event_type : e ) {
         const Pattern pattern{ event_type };
         
         for ( TimeSlot time_slot = first_time_slot; time_slot < first_time_slot + time_slot_count; ++time_slot ) {
@@ -408,22 +558,43 @@ std::map<size_t, std::set<Pattern>> mine_closed_mdcops(const std::set<EventType>
     }
     
     std::map<size_t, std::map<TimeSlot, std::map<Pattern, TableInstance>>> t;  // pattern instances grouped by size and time slot
-    for ( const auto& pair : st.objects_by_event_type ) {
-        const EventType& event_type = pair.first;
-            
+    for ( const EventType event_type : e ) {
         const Pattern pattern{ event_type };
 
         for ( TimeSlot time_slot = first_time_slot; time_slot < first_time_slot + time_slot_count; ++time_slot ) {
-            TableInstance table;
-            for ( const std::shared_ptr<Object>& object : st.objects_by_event_type.at( event_type ) ) {
-                if ( object->time_slot == time_slot ) {
-                    table[std::set<std::shared_ptr<Object>>{}].insert( object );
-                }
-            }
-            t[k][time_slot][pattern] = table;
+            // a single group with an empty prefix
+            TableInstance table( 0 );
+            const ObjectRange objects = st.objects.event_type_range( st.objects.time_slot_range( time_slot ), event_type );
+            for ( ObjectIndex object = objects.first; object < objects.second; ++object ) { table.last_objects.push_back( object ); }
+            table.close_group( nullptr );
+            t[k][time_slot][pattern] = std::move( table );
         }
     }
     
+    // time slots, candidate patterns and joins are all tasks of a single pool, so that threads which run out of work help with the
+    // biggest pieces of work left, whatever their level
+    ThreadPool pool( thread_count );
+    
+    // neighbor graphs of the objects grouped by time slot: every pair of objects is tested by r exactly once, no matter how many
+    // patterns and pattern sizes need it
+    std::map<TimeSlot, std::shared_ptr<NeighborGraph>> graphs;
+    for ( TimeSlot time_slot = first_time_slot; time_slot < first_time_slot + time_slot_count; ++time_slot ) {
+        const auto i = precomputed.find( time_slot );
+        graphs[time_slot] = i != precomputed.end() ? (*i).second.graph : nullptr;
+    }
+    parallel_for( pool, time_slot_count, [&](size_t i) {
+        const TimeSlot time_slot = first_time_slot + (TimeSlot) i;
+        if ( !graphs.at( time_slot ) ) { graphs.at( time_slot ) = std::make_shared<NeighborGraph>( st.objects, time_slot, r ); }
+    } );
+    
+    // step 2. for patterns of size 2 only looks up the precomputed instances, if any
+    const auto gen_time_slot_co_occ_inst = [&](const TimeSlot time_slot, const std::map<Pattern, SubPatterns>& candidates,
+                                               const std::map<Pattern, TableInstance>& prev_t) {
+        const auto i = precomputed.find( time_slot );
+        if ( k == 1 && i != precomputed.end() ) { return take_co_occ_inst( candidates, (*i).second.size2_tables ); }
+        return gen_co_occ_inst( candidates, prev_t, *graphs.at( time_slot ), pool );
+    };
+    
     std::map<Pattern, std::vector<float>> spatial_indexes_by_pattern;  // pattern spatial indexes
     
     // algorithm
@@ -448,18 +619,68 @@ std::map<size_t, std::set<Pattern>> mine_closed_mdcops(const std::set<EventType>
             }
         }
         
+        // with more than one thread, steps 2. and 3. (which only depend on the time slot) are done for all time slots at once, with
+        // all the candidate patterns of each time slot; then time slots are processed in order as usual, skipping the candidate patterns
+        // that the previous time slots pruned, so that the results are the ones of a sequential run
+        std::map<TimeSlot, std::map<Pattern, float>> partecipation_indexes_by_time_slot;
+        if ( thread_count > 1 ) {
+            for ( TimeSlot time_slot = first_time_slot; time_slot < first_time_slot+time_slot_count; ++time_slot ) {
+                c[k+1][time_slot];
+                t[k+1][time_slot];
+                partecipation_indexes_by_time_slot[time_slot];
+            }
+            
+            // threads only look up the maps prepared above, and each one writes to the values of its own time slot
+            const std::map<TimeSlot, std::map<Pattern, SubPatterns>>& candidates_by_time_slot = c.at( k+1 );
+            const std::map<TimeSlot, std::map<Pattern, TableInstance>>& prev_t = t.at( k );
+            std::map<TimeSlot, std::map<Pattern, TableInstance>>& next_t = t.at( k+1 );
+            parallel_for( pool, time_slot_count, [&](size_t i) {
+                const TimeSlot time_slot = first_time_slot + (TimeSlot) i;
+                
+                std::map<Pattern, TableInstance>& time_slot_t = next_t.at( time_slot );
+                time_slot_t = gen_time_slot_co_occ_inst( time_slot, candidates_by_time_slot.at( time_slot ), prev_t.at( time_slot ) );
+                
+                std::map<Pattern, float>& partecipation_indexes = partecipation_indexes_by_time_slot.at( time_slot );
+                for ( const auto& pair : time_slot_t ) {
+                    partecipation_indexes.emplace_hint( partecipation_indexes.cend(), pair.first,
+                                                        find_partecipation_index( st.object_count_by_event_type, pair.first, pair.second ) );
+                }
+            } );
+            
+            // erase tables not needed anymore
+            t.erase( k );
+        }
+        
         // for each time slot
         for ( TimeSlot time_slot = first_time_slot; time_slot < first_time_slot+time_slot_count; ++time_slot ) {
             std::cout << std::setw( 10 ) << std::left << " " << "Iterating for time_slot=" << time_slot << "..." << std::endl;
             
-            // 2. given a set of candidate patterns, find their instances by reusing instances of patterns of size k
-            t[k+1][time_slot] = gen_co_occ_inst( c[k+1][time_slot], t[k][time_slot], r );
-            
-            // erase tables not needed anymore
-            t[k].erase( t[k].find( time_slot ) );
-
-            // 3. find which patterns are spatial prevalent
-            const std::set<Pattern> sp = find_spatial_prev_co_occ( st.objects_by_event_type, t[k+1][time_slot], p, spatial_indexes_by_pattern );
+            std::set<Pattern> sp;
+            if ( thread_count == 1 ) {
+                // 2. given a set of candidate patterns, find their instances by reusing instances of patterns of size k
+                t[k+1][time_slot] = gen_time_slot_co_occ_inst( time_slot, c[k+1][time_slot], t[k][time_slot] );
+                
+                // erase tables not needed anymore
+                t[k].erase( t[k].find( time_slot ) );
+                
+                // 3. find which patterns are spatial prevalent
+                sp = find_spatial_prev_co_occ( st.object_count_by_event_type, t[k+1][time_slot], p, spatial_indexes_by_pattern );
+            }
+            else {
+                // 2. and 3. were already done, but also for the candidate patterns pruned by the previous time slots: drop them
+                std::map<Pattern, float>& partecipation_indexes = partecipation_indexes_by_time_slot.at( time_slot );
+                for ( auto i = partecipation_indexes.cbegin(); i != partecipation_indexes.cend(); ) {
+                    const Pattern& pattern = (*i).first;
+                    
+                    if ( !c[k+1][time_slot].count( pattern ) ) {
+                        t[k+1][time_slot].erase( pattern );
+                        partecipation_indexes.erase( i++ );
+                    }
+                    else { ++i; }
+                }
+                
+                sp = find_spatial_prev_co_occ( partecipation_indexes, p, spatial_indexes_by_pattern );
+            }
             
             // remove the candidates patterns of the current time slot which are not spatial prevalent patterns
             for ( auto i = c[k+1][time_slot].cbegin(); i != c[k+1][time_slot].cend(); ) {
@@ -474,7 +695,7 @@ std::map<size_t, std::set<Pattern>> mine_closed_mdcops(const std::set<EventType>
             
             // 5. find time prevalent patterns from the time prevalence table (also prune patterns from the time prevalence table that will
             // not be time prevalent even if they are spatial prevalent in the remaining time slots)
-            cmdp[k+1] = find_time_prev_co_occ( tp, time, time_slot_count, time_slot );
+            cmdp[k+1] = find_time_prev_co_occ( tp, time, time_slot_count, time_slot-first_time_slot );
             
             // for the next time slots, from all candidate patterns remove the candidates which were just pruned from the time prevalence table
             for ( int t = time_slot+1; t < first_time_slot+time_slot_count; ++t ) {
@@ -488,7 +709,8 @@ std::map<size_t, std::set<Pattern>> mine_closed_mdcops(const std::set<EventType>
         }
         
         // after processing the last time slot, cmdp[k+1] contains all the mdcops of size k+1
-        std::cout << std::setw( 5 ) << std::left << " " << "MDCOPs found (" << cmdp[k+1].size() << "): " << cmdp[k+1] << std::endl;
+        std::cout << std::setw( 5 ) << std::left << " " << "MDCOPs found (" << cmdp[k+1].size() << "): "
+                  << pattern_names( st.event_type_dictionary, cmdp[k+1] ) << std::endl;
 
         // having mdcops of size k+1, it is possible to prune all mdcops of size k which are not closed mdcops
         const size_t prev_mdcop_count = cmdp[k].size();
@@ -497,6 +719,7 @@ std::map<size_t, std::set<Pattern>> mine_closed_mdcops(const std::set<EventType>
         }
         if ( prev_mdcop_count > cmdp[k].size() ) { std::cout << std::setw( 5 ) << std::left << " " << "Found non-closed MDCOPs!" << std::endl; }
         
+        if ( k == 1 ) { precomputed.clear(); }
         ++k;
     }
 
@@ -0,0 +1,181 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binary_dataset.hpp"
+#include "dataset.hpp"
+#include "mapped_file.hpp"
+#include "object.hpp"
+#include "object_store.hpp"
+
+
+namespace {
+    const char MAGIC[8] = { 'M', 'D', 'C', 'O', 'P', 'B', 'I', 'N' };
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+    const uint32_t VERSION = 1;
+    
+    size_t padded(size_t size) { return (size+7)/8*8; }
+    
+    struct Writer {
+        std::ofstream& file;
+        
+        template<typename T>
+        void write(const T& value) { file.write( reinterpret_cast<const char*>( &value ), sizeof( T ) ); }
+        void write(const char* data, size_t size) {
+            static const char padding[8] = {};
+            file.write( data, size );
+            file.write( padding, padded( size )-size );
+        }
+        template<typename T>
+        void write_column(const std::vector<T>& column) {
+            write( reinterpret_cast<const char*>( column.data() ), column.size()*sizeof( T ) );
+        }
+    };
+    
+    struct Reader {
+        // reads the sections of a mapped file one after the other, checking that they are all inside the file
+        const MappedFile& file;
+        size_t offset;
+        
+        const char* read(size_t size, bool padding = true) {
+            if ( size > file.size || offset > file.size-size ) { throw std::runtime_error( "Truncated binary dataset file" ); }
+            const char* data = file.data + offset;
+            offset += padding ? padded( size ) : size;
+            return data;
+        }
+        template<typename T>
+        T read() {
+            T value;
+            std::memcpy( &value, read( sizeof( T ), false ), sizeof( T ) );
+            return value;
+        }
+        template<typename T>
+        const char* read_column(uint64_t count) {
+            if ( count > file.size/sizeof( T ) ) { throw std::runtime_error( "Truncated binary dataset file" ); }
+            return read( (size_t) count*sizeof( T ) );
+        }
+    };
+    
+    template<typename T>
+    void copy_column(const char* column, ObjectRange range, std::vector<T>& values) {
+        values.resize( range.second-range.first );
+        if ( !values.empty() ) { std::memcpy( values.data(), column + range.first*sizeof( T ), values.size()*sizeof( T ) ); }
+    }
+}
+
+
+bool write_binary_dataset(const Dataset& dataset, const std::string& dataset_file_path) {
+    std::ofstream file( dataset_file_path, std::ios::binary );
+    if ( !file ) { return false; }
+    Writer writer{ file };
+    
+    const ObjectStore& objects = dataset.objects;
+    writer.write( MAGIC, sizeof( MAGIC ) );
+    writer.write( BYTE_ORDER_MARK );
+    writer.write( VERSION );
+    writer.write( uint64_t( objects.size() ) );
+    writer.write( uint64_t( dataset.event_type_dictionary.names.size() ) );
+    writer.write( uint64_t( objects.ranges_by_time_slot.size() ) );
+    
+    for ( EventType event_type = 0; event_type < dataset.event_type_dictionary.names.size(); ++event_type ) {
+        const std::string& name = dataset.event_type_dictionary.name( event_type );
+        writer.write( uint64_t( dataset.object_count_by_event_type[event_type] ) );
+        writer.write( uint64_t( name.size() ) );
+        writer.write( name.data(), name.size() );
+    }
+    
+    for ( const auto& pair : objects.ranges_by_time_slot ) {
+        writer.write( uint64_t( pair.first ) );
+        writer.write( uint64_t( pair.second.first ) );
+    }
+    
+    writer.write_column( objects.x );
+    writer.write_column( objects.y );
+    writer.write_column( objects.event_type );
+    writer.write_column( objects.id );
+    writer.write_column( objects.time_slot );
+    
+    file.close();
+    return (bool) file;
+}
+
+
+bool is_binary_dataset(const MappedFile& file) {
+    return file.size >= sizeof( MAGIC ) && std::memcmp( file.data, MAGIC, sizeof( MAGIC ) ) == 0;
+}
+
+
+Dataset construct_binary_dataset(const MappedFile& file, const std::pair<TimeSlot, unsigned> window) {
+    Reader reader{ file, 0 };
+    
+    reader.read( sizeof( MAGIC ) );
+    if ( reader.read<uint32_t>() != BYTE_ORDER_MARK ) { throw std::runtime_error( "Binary dataset file of another byte order" ); }
+    if ( reader.read<uint32_t>() != VERSION ) { throw std::runtime_error( "Unsupported binary dataset file version" ); }
+    const uint64_t object_count = reader.read<uint64_t>();
+    const uint64_t event_type_count = reader.read<uint64_t>();
+    const uint64_t time_slot_count = reader.read<uint64_t>();
+    
+    Dataset dataset = Dataset();
+    for ( uint64_t i = 0; i < event_type_count; ++i ) {
+        const uint64_t event_type_object_count = reader.read<uint64_t>();
+        const uint64_t name_size = reader.read<uint64_t>();
+        if ( name_size > file.size ) { throw std::runtime_error( "Truncated binary dataset file" ); }
+        const char* name = reader.read( (size_t) name_size );
+        
+        const EventType event_type = dataset.event_type_dictionary.intern( std::string( name, (size_t) name_size ) );
+        if ( event_type != i ) { throw std::runtime_error( "Duplicate event type in binary dataset file" ); }
+        dataset.event_types.insert( event_type );
+        dataset.object_count_by_event_type.push_back( (size_t) event_type_object_count );
+    }
+    dataset.time_slot_count = (size_t) time_slot_count;
+    
+    // only the objects of the time slots of the window are copied, as a single range since objects are sorted by time slot
+    const std::pair<TimeSlot, unsigned> clamped_window = clamp_time_slots( window, dataset.time_slot_count );
+    const uint64_t window_end = uint64_t( clamped_window.first ) + clamped_window.second;
+    ObjectRange window_objects{ 0, 0 };
+    bool window_started = false;
+    
+    if ( time_slot_count > file.size ) { throw std::runtime_error( "Truncated binary dataset file" ); }
+    std::vector<std::pair<TimeSlot, uint64_t>> first_objects;
+    const char* time_slot_table = reader.read_column<uint64_t>( 2*time_slot_count );
+    for ( uint64_t i = 0; i < time_slot_count; ++i ) {
+        uint64_t entry[2];
+        std::memcpy( entry, time_slot_table + i*sizeof( entry ), sizeof( entry ) );
+        first_objects.push_back( { (TimeSlot) entry[0], entry[1] } );
+    }
+    for ( size_t i = 0; i < first_objects.size(); ++i ) {
+        const TimeSlot time_slot = first_objects[i].first;
+        const uint64_t first = first_objects[i].second;
+        const uint64_t last = i+1 < first_objects.size() ? first_objects[i+1].second : object_count;
+        if ( first > last || last > object_count || (i > 0 && time_slot <= first_objects[i-1].first) ) {
+            throw std::runtime_error( "Invalid time slot table in binary dataset file" );
+        }
+        if ( time_slot < clamped_window.first || time_slot >= window_end ) { continue; }
+        
+        if ( !window_started ) { window_objects.first = (ObjectIndex) first; window_started = true; }
+        window_objects.second = (ObjectIndex) last;
+        dataset.objects.ranges_by_time_slot[time_slot] = { (ObjectIndex) (first-window_objects.first),
+                                                            (ObjectIndex) (last-window_objects.first) };
+    }
+    
+    const char* x = reader.read_column<float>( object_count );
+    const char* y = reader.read_column<float>( object_count );
+    const char* event_type = reader.read_column<EventType>( object_count );
+    const char* id = reader.read_column<ObjectId>( object_count );
+    const char* time_slot = reader.read_column<TimeSlot>( object_count );
+    
+    copy_column( x, window_objects, dataset.objects.x );
+    copy_column( y, window_objects, dataset.objects.y );
+    copy_column( event_type, window_objects, dataset.objects.event_type );
+    copy_column( id, window_objects, dataset.objects.id );
+    copy_column( time_slot, window_objects, dataset.objects.time_slot );
+    
+    for ( const EventType object_event_type : dataset.objects.event_type ) {
+        if ( object_event_type >= event_type_count ) { throw std::runtime_error( "Invalid event type in binary dataset file" ); }
+    }
+    return dataset;
+}
@@ -1,70 +1,385 @@
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
-#include <memory>
+#include <set>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "prettyprint.hpp"
 
+#include "binary_dataset.hpp"
 #include "dataset.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
 #include "object.hpp"
+#include "object_store.hpp"
+
+
+namespace {
+    bool is_space(char c) {
+        // as std::isspace in the "C" locale
+        return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+    }
+    bool is_digit(char c) { return c >= '0' && c <= '9'; }
+    
+    void skip_spaces(const char*& cursor, const char* end) {
+        while ( cursor != end && is_space( *cursor ) ) { ++cursor; }
+    }
+    
+    bool parse_float(const char*& cursor, const char* end, float& value) {
+        // parse a float as operator>>(float&) does: the characters which may belong to a number ([+-]digits[.digits][(e|E)[+-]digits])
+        // are consumed, then the number must be all of them and must not overflow
+        skip_spaces( cursor, end );
+        const char* const begin = cursor;
+        
+        bool negative = false;
+        if ( cursor != end && (*cursor == '+' || *cursor == '-') ) { negative = *cursor == '-'; ++cursor; }
+        
+        // the digits are accumulated in mantissa for as long as it is exact as a double
+        const uint64_t max_mantissa = uint64_t( 1 ) << 53;
+        uint64_t mantissa = 0;
+        bool exact = true;
+        int exponent = 0;
+        bool found_mantissa = false;
+        
+        for ( ; cursor != end && is_digit( *cursor ); ++cursor ) {
+            found_mantissa = true;
+            if ( mantissa <= (max_mantissa - 9)/10 ) { mantissa = mantissa*10 + (*cursor - '0'); }
+            else { exact = false; }
+        }
+        if ( cursor != end && *cursor == '.' ) {
+            for ( ++cursor; cursor != end && is_digit( *cursor ); ++cursor ) {
+                found_mantissa = true;
+                if ( mantissa <= (max_mantissa - 9)/10 ) { mantissa = mantissa*10 + (*cursor - '0'); --exponent; }
+                else { exact = false; }
+            }
+        }
+        bool found_exponent_digits = true;
+        if ( found_mantissa && cursor != end && (*cursor == 'e' || *cursor == 'E') ) {
+            ++cursor;
+            bool negative_exponent = false;
+            if ( cursor != end && (*cursor == '+' || *cursor == '-') ) { negative_exponent = *cursor == '-'; ++cursor; }
+            
+            int explicit_exponent = 0;
+            found_exponent_digits = false;
+            for ( ; cursor != end && is_digit( *cursor ); ++cursor ) {
+                found_exponent_digits = true;
+                if ( explicit_exponent < 10000 ) { explicit_exponent = explicit_exponent*10 + (*cursor - '0'); }
+            }
+            exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+        }
+        if ( !found_mantissa || !found_exponent_digits ) { return false; }
+        
+        // fast path: both mantissa and the power of ten are exact doubles, so their product (or quotient) is the double nearest to the
+        // number, and rounding it to a float gives the float nearest to the number unless it lies exactly halfway between two floats
+        static const double powers_of_ten[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        if ( exact && exponent >= -22 && exponent <= 22 ) {
+            const double d = exponent < 0 ? mantissa / powers_of_ten[-exponent] : mantissa * powers_of_ten[exponent];
+            const float f = (float) d;
+            const double fd = f;
+            bool halfway = false;
+            if ( fd != d ) {
+                const float next = std::nextafter( f, d > fd ? HUGE_VALF : -HUGE_VALF );
+                halfway = d - fd == (double) next - d;
+            }
+            if ( !halfway ) {
+                value = negative ? -f : f;
+                return true;
+            }
+        }
+        
+        // slow path: let strtof parse the consumed characters
+        const std::string number( begin, cursor );
+        char* number_end;
+        value = std::strtof( number.c_str(), &number_end );
+        return number_end == number.c_str() + number.size() && !std::isinf( value );
+    }
+    
+    bool parse_unsigned(const char*& cursor, const char* end, unsigned& value) {
+        // parse an unsigned as operator>>(unsigned&) does: a sign and at least one digit, and a negative number is wrapped
+        skip_spaces( cursor, end );
+        
+        bool negative = false;
+        if ( cursor != end && (*cursor == '+' || *cursor == '-') ) { negative = *cursor == '-'; ++cursor; }
+        
+        uint64_t result = 0;
+        bool found_digits = false;
+        for ( ; cursor != end && is_digit( *cursor ); ++cursor ) {
+            found_digits = true;
+            result = result*10 + (*cursor - '0');
+            if ( result > 0xFFFFFFFFull ) { return false; }
+        }
+        if ( !found_digits ) { return false; }
+        
+        value = negative ? (unsigned) -(uint32_t) result : (unsigned) result;
+        return true;
+    }
+    
+    void add_object(Dataset& dataset, std::vector<Object>& objects, EventType event_type, float x, float y, TimeSlot time_slot) {
+        if ( event_type == dataset.object_count_by_event_type.size() ) { dataset.object_count_by_event_type.push_back( 0 ); }
+        
+        // generate object id: "A0", "B0", "A1", ...
+        ObjectId id = (ObjectId) dataset.object_count_by_event_type[event_type]++;
+        
+        // add object to dataset
+        dataset.event_types.insert( event_type );
+        objects.push_back( Object( event_type, id, x, y, time_slot ) );
+    }
+}
+
+
+bool parse_line(const char* line, const char* line_end, std::pair<const char*, const char*>& event_type_name, float& x, float& y,
+                TimeSlot& time_slot) {
+    // parse a line of a dataset as an std::istringstream of the line does, without copying it: the event type name is the range of
+    // the line it spans
+    skip_spaces( line, line_end );
+    event_type_name.first = line;
+    while ( line != line_end && !is_space( *line ) ) { ++line; }
+    event_type_name.second = line;
+    if ( event_type_name.first == event_type_name.second ) { return false; }
+    
+    return parse_float( line, line_end, x ) && parse_float( line, line_end, y ) && parse_unsigned( line, line_end, time_slot );
+}
 
 
 Dataset construct_dataset(std::ifstream& dataset_file) {
     assert( dataset_file );
     
-    Dataset dataset;
+    Dataset dataset = Dataset();
+    std::vector<Object> objects;
     
     // read input file line per line
     std::string line;
     while ( std::getline( dataset_file, line ) ) {
         std::istringstream iss( line );
         
-        EventType event_type;
+        std::string event_type_name;
         float x, y;
         TimeSlot time_slot;
         // check if the line is well-formed, otherwise skip it
-        if ( (iss >> event_type >> x >> y >> time_slot) ) {
-            // generate object id: "A0", "B0", "A1", ...
-            ObjectId id = (ObjectId) dataset.objects_by_event_type[event_type].size();
+        if ( (iss >> event_type_name >> x >> y >> time_slot) ) {
+            add_object( dataset, objects, dataset.event_type_dictionary.intern( event_type_name ), x, y, time_slot );
+        }
+    }
+    
+    dataset.objects = ObjectStore( objects );
+    dataset.time_slot_count = dataset.objects.ranges_by_time_slot.size();
+    return dataset;
+}
+
+std::pair<TimeSlot, unsigned> clamp_time_slots(const std::pair<TimeSlot, unsigned> window, const size_t time_slot_count) {
+    if ( time_slot_count == 0 ) { return { 0, 0 }; }
+    
+    const TimeSlot first_time_slot = (TimeSlot) std::min<size_t>( window.first, time_slot_count-1 );
+    return { first_time_slot, (unsigned) std::min<size_t>( window.second, time_slot_count-first_time_slot ) };
+}
+
+
+Dataset construct_dataset(const std::string& dataset_file_path, const unsigned thread_count, const std::pair<TimeSlot, unsigned> window,
+                          const size_t min_chunk_size) {
+    const MappedFile file( dataset_file_path );
+    if ( !file.mapped ) {
+        std::ifstream dataset_file( dataset_file_path );
+        return construct_dataset( dataset_file );
+    }
+    if ( is_binary_dataset( file ) ) { return construct_binary_dataset( file, window ); }
+    
+    // the file is split in chunks of whole lines, parsed concurrently into objects whose event types and ids are local to the chunk:
+    // a chunk names its event types in the order it first reads them, and counts the objects of each one
+    // only the objects of the time slots of the window are kept, but all objects are counted and all time slots are collected, so
+    // that the dataset still knows the object count of each event type and the time slot count of the whole file
+    struct Chunk {
+        const char* begin;
+        const char* end;
+        
+        EventTypeDictionary event_type_dictionary;
+        std::vector<size_t> object_count_by_event_type;
+        std::set<TimeSlot> time_slots;
+        std::vector<EventType> event_type;
+        std::vector<ObjectId> id;  // among the objects of the event type in the chunk
+        std::vector<float> x, y;
+        std::vector<TimeSlot> time_slot;
+        
+        // the event types of the dataset of the local ones, and the id of the first object of each one
+        std::vector<EventType> dataset_event_types;
+        std::vector<ObjectId> first_ids;
+        size_t first_object;  // the position of the first object of the chunk in the file
+    };
+    
+    // a few chunks per thread, so that threads which are done early can help with the others, but none smaller than min_chunk_size
+    const size_t chunk_count = std::max<size_t>( 1, std::min<size_t>( thread_count > 1 ? 4*thread_count : 1, file.size/min_chunk_size ) );
+    
+    const char* const file_end = file.data + file.size;
+    std::vector<Chunk> chunks( chunk_count );
+    for ( size_t i = 0; i < chunk_count; ++i ) {
+        // a chunk starts right after the end of the line its nominal start falls in, and ends where the next one starts
+        const char* begin = file.data + file.size/chunk_count*i;
+        if ( i > 0 ) {
+            const char* const previous_line_end = static_cast<const char*>( std::memchr( begin-1, '\n', file_end-(begin-1) ) );
+            begin = previous_line_end ? previous_line_end+1 : file_end;
+        }
+        chunks[i].begin = begin;
+        if ( i > 0 ) { chunks[i-1].end = begin; }
+    }
+    chunks.back().end = file_end;
+    
+    // 1. parse chunks
+    ThreadPool pool( thread_count );
+    parallel_for( pool, chunk_count, [&chunks, window](size_t i) {
+        Chunk& chunk = chunks[i];
+        
+        // scan the chunk line per line
+        std::string event_type_name;
+        EventType event_type = 0;
+        TimeSlot last_time_slot = 0;
+        for ( const char* line = chunk.begin, *next_line; line != chunk.end; line = next_line ) {
+            const char* line_end = static_cast<const char*>( std::memchr( line, '\n', chunk.end-line ) );
+            if ( !line_end ) { line_end = chunk.end; }
+            next_line = line_end == chunk.end ? chunk.end : line_end+1;
             
-            // add object to dataset
-            std::shared_ptr<Object> object = std::make_shared<Object>( event_type, id, x, y, time_slot );
+            std::pair<const char*, const char*> name;
+            float x, y;
+            TimeSlot time_slot;
+            // check if the line is well-formed, otherwise skip it
+            if ( parse_line( line, line_end, name, x, y, time_slot ) ) {
+                // lines of the same event type often come in runs, so the name is only interned (i.e. copied and hashed) when it changes
+                const size_t name_size = name.second - name.first;
+                if ( event_type_name.size() != name_size || event_type_name.compare( 0, name_size, name.first, name_size ) != 0 ) {
+                    event_type_name.assign( name.first, name_size );
+                    event_type = chunk.event_type_dictionary.intern( event_type_name );
+                    if ( event_type == chunk.object_count_by_event_type.size() ) { chunk.object_count_by_event_type.push_back( 0 ); }
+                }
+                const ObjectId id = (ObjectId) chunk.object_count_by_event_type[event_type]++;
+                
+                // (time slots too usually come in runs)
+                if ( chunk.time_slots.empty() || time_slot != last_time_slot ) {
+                    chunk.time_slots.insert( time_slot );
+                    last_time_slot = time_slot;
+                }
+                
+                if ( time_slot < window.first || time_slot-window.first >= window.second ) { continue; }
+                chunk.event_type.push_back( event_type );
+                chunk.id.push_back( id );
+                chunk.x.push_back( x );
+                chunk.y.push_back( y );
+                chunk.time_slot.push_back( time_slot );
+            }
+        }
+    } );
+    
+    // 2. merge the event types of the chunks in file order, so that event types are named in the order the file first mentions them;
+    // the objects of an event type are numbered in file order too ("A0", "B0", "A1", ...), so the first id of an event type in a chunk
+    // is the number of objects of that event type in the chunks before it
+    Dataset dataset = Dataset();
+    std::set<TimeSlot> time_slots;
+    size_t object_count = 0;
+    for ( Chunk& chunk : chunks ) {
+        time_slots.insert( chunk.time_slots.cbegin(), chunk.time_slots.cend() );
+        
+        for ( EventType event_type = 0; event_type < chunk.event_type_dictionary.names.size(); ++event_type ) {
+            const EventType dataset_event_type = dataset.event_type_dictionary.intern( chunk.event_type_dictionary.name( event_type ) );
+            if ( dataset_event_type == dataset.object_count_by_event_type.size() ) { dataset.object_count_by_event_type.push_back( 0 ); }
+            dataset.event_types.insert( dataset_event_type );
             
-            dataset.event_types.insert( event_type );
-            dataset.objects.insert( object );
-            dataset.objects_by_event_type[object->event_type].insert( object );
-            dataset.objects_by_time_slot[object->time_slot].insert( object );
+            chunk.dataset_event_types.push_back( dataset_event_type );
+            chunk.first_ids.push_back( (ObjectId) dataset.object_count_by_event_type[dataset_event_type] );
+            dataset.object_count_by_event_type[dataset_event_type] += chunk.object_count_by_event_type[event_type];
         }
+        
+        chunk.first_object = object_count;
+        object_count += chunk.event_type.size();
     }
     
+    // 3. copy the objects of each chunk to its place in file order, translating event types and assigning ids
+    std::vector<EventType> event_type( object_count );
+    std::vector<ObjectId> id( object_count );
+    std::vector<float> x( object_count ), y( object_count );
+    std::vector<TimeSlot> time_slot( object_count );
+    parallel_for( pool, chunk_count, [&](size_t i) {
+        Chunk& chunk = chunks[i];
+        
+        for ( size_t j = 0; j < chunk.event_type.size(); ++j ) {
+            const size_t object = chunk.first_object + j;
+            event_type[object] = chunk.dataset_event_types[chunk.event_type[j]];
+            id[object] = chunk.first_ids[chunk.event_type[j]] + chunk.id[j];
+            x[object] = chunk.x[j];
+            y[object] = chunk.y[j];
+            time_slot[object] = chunk.time_slot[j];
+        }
+        
+        // free the chunk as soon as possible
+        chunk = Chunk();
+    } );
+    
+    dataset.objects = ObjectStore( event_type, id, x, y, time_slot );
+    dataset.time_slot_count = time_slots.size();
+    
+    // a window starting after the last time slot is clamped to the last time slot, which was not kept: read it again
+    const std::pair<TimeSlot, unsigned> clamped_window = clamp_time_slots( window, dataset.time_slot_count );
+    if ( clamped_window.second > 0 && clamped_window.first < window.first ) {
+        return construct_dataset( dataset_file_path, thread_count, clamped_window, min_chunk_size );
+    }
     return dataset;
 }
 
+
+std::vector<size_t> window_object_count_by_event_type(const Dataset& dataset, const std::pair<TimeSlot, unsigned> window) {
+    std::vector<size_t> object_count_by_event_type( dataset.object_count_by_event_type.size(), 0 );
+    for ( const auto& pair : dataset.objects.ranges_by_time_slot ) {
+        const TimeSlot time_slot = pair.first;
+        if ( time_slot < window.first || time_slot-window.first >= window.second ) { continue; }
+        
+        for ( ObjectIndex object = pair.second.first; object < pair.second.second; ++object ) {
+            ++object_count_by_event_type[dataset.objects.event_type[object]];
+        }
+    }
+    return object_count_by_event_type;
+}
+
+void restrict_denominators_to_window(Dataset& dataset, const std::pair<TimeSlot, unsigned> window) {
+    dataset.object_count_by_event_type = window_object_count_by_event_type( dataset, window );
+}
+
 void print_dataset_info(const Dataset& dataset) {
     std::cout << "Dataset info: " << std::endl;
     
-    // print object count
-    int object_count = 0;
-    for ( const auto& pair: dataset.objects_by_event_type ) { object_count += pair.second.size(); }
+    // print object count, of the whole dataset like the counts by event type, and the count of the objects loaded if only the ones
+    // of a window were
+    size_t object_count = 0;
+    for ( const size_t count : dataset.object_count_by_event_type ) { object_count += count; }
     std::cout << std::setw( 5 ) << std::left << " " << "object count: " << object_count << std::endl;
+    if ( dataset.objects.size() != object_count ) {
+        std::cout << std::setw( 5 ) << std::left << " " << "loaded object count: " << dataset.objects.size() << std::endl;
+    }
     
     // print object types
-    std::cout << std::setw( 5 ) << std::left << " " << "event types: " << dataset.event_types << std::endl;
+    std::set<std::string> event_type_names;
+    for ( const EventType event_type : dataset.event_types ) { event_type_names.insert( dataset.event_type_dictionary.name( event_type ) ); }
+    std::cout << std::setw( 5 ) << std::left << " " << "event types: " << event_type_names << std::endl;
 
     // print object count by event type
-    std::map<EventType, unsigned long> object_count_by_type;
-    for ( const auto& pair : dataset.objects_by_event_type ) { object_count_by_type[pair.first] = pair.second.size(); }
+    std::map<std::string, unsigned long> object_count_by_type;
+    for ( const EventType event_type : dataset.event_types ) {
+        object_count_by_type[dataset.event_type_dictionary.name( event_type )] = dataset.object_count_by_event_type[event_type];
+    }
     std::cout << std::setw( 5 ) << std::left << " " << "object count by event type: " << object_count_by_type << std::endl;
     
     // print time slot count
-    std::cout << std::setw( 5 ) << std::left << " " << "time slot count: " << dataset.objects_by_time_slot.size() << std::endl;
+    std::cout << std::setw( 5 ) << std::left << " " << "time slot count: " << dataset.time_slot_count << std::endl;
     
     // print object count by time slot
     std::map<int, unsigned long> object_count_by_time_slot;
-    for ( const auto& pair : dataset.objects_by_time_slot ) { object_count_by_time_slot[pair.first] = pair.second.size(); }
+    for ( const auto& pair : dataset.objects.ranges_by_time_slot ) { object_count_by_time_slot[pair.first] = pair.second.second-pair.second.first; }
     std::cout << std::setw( 5 ) << std::left << " " << "object count by time slot: " << object_count_by_time_slot << std::endl;
 }
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <memory>
 
@@ -6,39 +7,31 @@
 
 
 EuclideanDistance::EuclideanDistance(float dt) :
-    squared_dt( dt*dt ) {
+    dt( dt ), squared_dt( dt*dt ) {
 }
 
-bool EuclideanDistance::neighbors(const std::shared_ptr<Object>& object1, const std::shared_ptr<Object>& object2) {
-    float dx = object1->x-object2->x;
-    float dy = object1->y-object2->y;
-    return (dx*dx + dy*dy) <= squared_dt;
-}
 
 
+// the angle of the arcs of dt km on the sphere is widened by 1% and 1e-4 degrees for the bounding boxes, far beyond the relative
+// error of the float haversine (about 1e-4 of the distance)
+static double box_angle(float dt) { return dt/6371. * 1.01 + 1e-4 * 3.14159265358979323846/180; }
 
 LatLonDistance::LatLonDistance(float dt) :
-    dt( dt ) {
+    dt( dt ), latitude_band( (float) (box_angle( dt ) * 180/3.14159265358979323846) ), box_test_count( 0 ), box_rejected_count( 0 ) {
 }
 
-inline float deg_to_rad(float deg) {
-    return deg * 3.14159265358979323846/180;
+float LatLonDistance::longitude_window(float lat) const {
+    // the meridians tangent to the circle of angle a around a point of latitude phi are asin(sin(a)/cos(phi)) away from it
+    const double pi = 3.14159265358979323846;
+    const double phi = std::fabs( lat ) * pi/180;
+    const double a = box_angle( dt );
+    if ( phi + a >= pi/2 ) { return 180; }
+    return (float) std::min( std::asin( std::sin( a )/std::cos( phi ) ) * 180/pi * 1.01, 180. );
 }
 
-bool LatLonDistance::neighbors(const std::shared_ptr<Object>& object1, const std::shared_ptr<Object>& object2) {
-    // see http://www.movable-type.co.uk/scripts/latlong.html
-    const float lat1 = object1->x, lat2 = object2->x;
-    const float lon1 = object1->y, lon2 = object2->y;
-    
-    static const float R = 6371;  // km
-    const float phi1 = deg_to_rad( lat1 );
-    const float phi2 = deg_to_rad( lat2 );
-    const float dphi = deg_to_rad( lat2-lat1 );
-    const float dlambda = deg_to_rad( lon2-lon1 );
-    
-    const float a = sinf( dphi/2 ) * sinf( dphi/2 ) + cosf( phi1 ) * cosf( phi2 ) * sinf( dlambda/2 ) * sinf( dlambda/2 );
-    const float c = 2 * atan2f( sqrtf( a ), sqrtf( 1-a ) );
-    
-    const float d = R * c;
-    return d <= dt;
+
+
+LatLonChordDistance::LatLonChordDistance(float dt) :
+    // an arc of angle dt/R has a chord of 2*sin(dt/(2R)), and no arc is longer than half the circumference
+    dt( dt ), squared_chord( (float) std::pow( 2 * std::sin( std::min( dt/6371., 3.14159265358979323846 )/2 ), 2 ) ) {
 }
@@ -1,17 +1,97 @@
 #include <algorithm>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "prettyprint.hpp"
 
 #include "algorithm.hpp"
+#include "binary_dataset.hpp"
 #include "dataset.hpp"
 #include "distances.hpp"
+#include "pattern.hpp"
+#include "pipeline.hpp"
+#include "prevalence_cache.hpp"
+#include "sliding_window.hpp"
+#include "spatial_index.hpp"
 
 
-bool validate_arguments(std::string dataset_file_path, int first_time_slot, int time_slot_count, std::string distance, float dt, float p, float time) {
+void print_results(const EventTypeDictionary& dictionary, const std::map<size_t, std::set<Pattern>>& cmdp) {
+    if ( cmdp.size() == 0 ) {
+        std::cout << "No Closed Mixed-Drove Spatiotemporal Co-Occurrence Patterns found." << std::endl;
+    }
+    else {
+        std::cout << "Closed Mixed-Drove Spatiotemporal Co-Occurrence Patterns: " << std::endl;
+        for ( const auto& pair : cmdp ) {
+            const size_t size = pair.first;
+            const std::set<Pattern>& patterns = pair.second;
+            std::cout << std::setw( 5 ) << std::left << " " << "size=" << size << " (" << patterns.size() << "): "
+                      << pattern_names( dictionary, patterns ) << std::endl;
+        }
+    }
+}
+
+void print_bounding_box_info(const INeighborRelation& r) {
+    // the pairs of objects the bounding boxes of the latlon distance rejected since the last call, if any pairs were tested without
+    // an index (see GeodesicCellIndex)
+    const LatLonDistance* const latlon = dynamic_cast<const LatLonDistance*>( &r );
+    if ( !latlon ) { return; }
+    const size_t test_count = latlon->box_test_count.exchange( 0 );
+    const size_t rejected_count = latlon->box_rejected_count.exchange( 0 );
+    if ( test_count == 0 ) { return; }
+    std::cout << std::setw( 5 ) << std::left << " " << "pairs rejected by bounding boxes: " << rejected_count << " of " << test_count << std::endl;
+}
+
+void print_usage() {
+    std::cerr << "Usage: ClosedMDCOP-Miner dataset_file_path first_time_slot time_slot_count distance dt p time [options]" << std::endl;
+    std::cerr << "Parameters:" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "dataset_file_path: the dataset file" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "first_time_slot: the starting time slot" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "time_slot_count: the number of time slots to mine" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "distance: the distance function to use ('euclidean', 'latlon', or 'latlon-chord', which"
+              << " finds the latlon distances of the pairs of objects from their points on the unit sphere, without trigonometry)" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "dt: the maximum distance for considering two objects as neighbors (0 < dt)" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "p: the spatial prevalence threshold (0 < p <= 1)" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "time: the time prevalence threshold (0 < time <= 1)" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "(dt, p and time can be comma separated lists of thresholds, which are all mined at once,"
+              << " printing the results of each combination)" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "--threads N: the number of threads reading the dataset and mining it (0 < N, default 1)" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "--denominators D: count the objects of each event type for partecipation ratios in the whole dataset"
+              << " ('dataset', default) or only in the mined time slots ('window')" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "--pipeline: start mining each time slot as soon as it is read, if the lines of the dataset"
+              << " are sorted by time slot" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "--slide N: after the time slots to mine, slide them forward one time slot at a time N times,"
+              << " mining each window by reusing what was found in the time slots it shares with the previous one (0 <= N)" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "--cache DIR: keep what is found in each time slot in the directory DIR, so that later runs"
+              << " with other thresholds or overlapping windows can reuse it" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "--index I: the index finding the neighbors of each object with the euclidean distance: a uniform"
+              << " grid ('grid'), a k-d tree, which suits clustered objects better ('tree'), or the one suited to each time slot ('auto', default)" << std::endl;
+    std::cerr << "Example: ClosedMDCOP-Miner dataset.txt 0 3 latlon 2 0.3 0.2 --threads 4" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "Usage: ClosedMDCOP-Miner convert dataset_file_path binary_dataset_file_path [--threads N]" << std::endl;
+    std::cerr << std::setw( 5 ) << std::left << " " << "convert a dataset to a binary dataset file, which loads without parsing" << std::endl;
+}
+
+std::vector<float> parse_thresholds(const std::string& argument) {
+    // one threshold, or a comma separated list of them
+    std::vector<float> thresholds;
+    std::istringstream iss( argument );
+    std::string threshold;
+    while ( std::getline( iss, threshold, ',' ) ) { thresholds.push_back( std::stof( threshold ) ); }
+    return thresholds;
+}
+
+bool validate_arguments(std::string dataset_file_path, int first_time_slot, int time_slot_count, std::string distance,
+                        std::vector<float> dts, std::vector<float> ps, std::vector<float> times, int thread_count, std::string denominators, int slide_count,
+                        std::string index) {
     std::ifstream dataset_file ( dataset_file_path );
     if ( !dataset_file ) {
         std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Failed to open dataset_file: " << dataset_file_path << std::endl;
@@ -25,44 +105,116 @@ bool validate_arguments(std::string dataset_file_path, int first_time_slot, int
         std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid time_slot_count: " << time_slot_count << std::endl;
         return false;
     }
-    if ( distance != "euclidean" && distance != "latlon" ) {
+    if ( distance != "euclidean" && distance != "latlon" && distance != "latlon-chord" ) {
         std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid distance: " << distance << std::endl;
         return false;
     }
-    if ( dt <= 0 ) {
-        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid dt: " << dt << std::endl;
+    if ( dts.empty() ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid dt" << std::endl;
         return false;
     }
-    if ( p <= 0 || p > 1 ) {
-        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid p: " << p << std::endl;
+    for ( const float dt : dts ) {
+        if ( dt <= 0 ) {
+            std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid dt: " << dt << std::endl;
+            return false;
+        }
+    }
+    if ( ps.empty() ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid p" << std::endl;
         return false;
     }
-    if ( time <= 0 || time > 1 ) {
-        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid time: " << time << std::endl;
+    for ( const float p : ps ) {
+        if ( p <= 0 || p > 1 ) {
+            std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid p: " << p << std::endl;
+            return false;
+        }
+    }
+    if ( times.empty() ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid time" << std::endl;
+        return false;
+    }
+    for ( const float time : times ) {
+        if ( time <= 0 || time > 1 ) {
+            std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid time: " << time << std::endl;
+            return false;
+        }
+    }
+    if ( thread_count <= 0 ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid thread count: " << thread_count << std::endl;
+        return false;
+    }
+    if ( denominators != "dataset" && denominators != "window" ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid denominators: " << denominators << std::endl;
+        return false;
+    }
+    if ( slide_count < 0 ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid slide count: " << slide_count << std::endl;
+        return false;
+    }
+    if ( index != "grid" && index != "tree" && index != "auto" ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid index: " << index << std::endl;
         return false;
     }
 
     return true;
 }
 
+int convert(int argc, const char *argv[]) {
+    // validate arguments
+    std::cout << "Validating arguments..." << std::endl;
+    
+    int thread_count = 1;
+    if ( argc == 1+5 && std::string( argv[4] ) == "--threads" ) { thread_count = std::stoi( argv[5] ); }
+    else if ( argc != 1+3 ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid number of arguments" << std::endl;
+        std::cerr << std::endl;
+        print_usage();
+        return EXIT_FAILURE;
+    }
+    
+    std::string dataset_file_path = argv[2];
+    std::string binary_dataset_file_path = argv[3];
+    if ( !std::ifstream( dataset_file_path ) ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Failed to open dataset_file: " << dataset_file_path << std::endl;
+        return EXIT_FAILURE;
+    }
+    if ( thread_count <= 0 ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid thread count: " << thread_count << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << std::endl;
+    
+    // construct dataset
+    std::cout << "Constructing dataset from '" << dataset_file_path << "'..." << std::endl;
+    Dataset dataset;
+    try { dataset = construct_dataset( dataset_file_path, (unsigned) thread_count ); }
+    catch ( const std::exception& e ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    print_dataset_info( dataset );
+    std::cout << std::endl;
+    
+    // write it as a binary dataset file
+    std::cout << "Writing binary dataset to '" << binary_dataset_file_path << "'..." << std::endl;
+    if ( !write_binary_dataset( dataset, binary_dataset_file_path ) ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Failed to write binary_dataset_file: " << binary_dataset_file_path << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, const char *argv[]) {
+    if ( argc > 1 && std::string( argv[1] ) == "convert" ) { return convert( argc, argv ); }
+    
     // validate arguments
     std::cout << "Validating arguments..." << std::endl;
     
-    if ( argc != 1+7 ) {
+    if ( argc < 1+7 ) {
         std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid number of arguments" << std::endl;
         std::cerr << std::endl;
-        
-        std::cerr << "Usage: ClosedMDCOP-Miner dataset_file_path first_time_slot time_slot_count distance dt p time" << std::endl;
-        std::cerr << "Parameters:" << std::endl;
-        std::cerr << std::setw( 5 ) << std::left << " " << "dataset_file_path: the dataset file" << std::endl;
-        std::cerr << std::setw( 5 ) << std::left << " " << "first_time_slot: the starting time slot" << std::endl;
-        std::cerr << std::setw( 5 ) << std::left << " " << "time_slot_count: the number of time slots to mine" << std::endl;
-        std::cerr << std::setw( 5 ) << std::left << " " << "distance: the distance function to use ('euclidean' or 'latlon')" << std::endl;
-        std::cerr << std::setw( 5 ) << std::left << " " << "dt: the maximum distance for considering two objects as neighbors (0 < dt)" << std::endl;
-        std::cerr << std::setw( 5 ) << std::left << " " << "p: the spatial prevalence threshold (0 < p <= 1)" << std::endl;
-        std::cerr << std::setw( 5 ) << std::left << " " << "time: the time prevalence threshold (0 < time <= 1)" << std::endl;
-        std::cerr << "Example: ClosedMDCOP-Miner dataset.txt 0 3 latlon 2 0.3 0.2" << std::endl;
+        print_usage();
         return EXIT_FAILURE;
     }
     
@@ -70,58 +222,155 @@ int main(int argc, const char *argv[]) {
     int first_time_slot = std::stoi( argv[2] );
     int time_slot_count = std::stoi( argv[3] );
     std::string distance = argv[4];
-    float dt = std::stof( argv[5] );
-    float p = std::stof( argv[6] );
-    float time = std::stof( argv[7] );
-    if ( !validate_arguments( dataset_file_path, first_time_slot, time_slot_count, distance, dt, p, time ) ) { return EXIT_FAILURE; }
+    std::vector<float> dts = parse_thresholds( argv[5] );
+    std::vector<float> ps = parse_thresholds( argv[6] );
+    std::vector<float> times = parse_thresholds( argv[7] );
+    
+    int thread_count = 1;
+    std::string denominators = "dataset";
+    bool pipeline = false;
+    bool sliding = false;
+    int slide_count = 0;
+    std::string cache_directory_path;
+    std::string index = "auto";
+    for ( int i = 1+7; i < argc; ++i ) {
+        const std::string option = argv[i];
+        if ( option == "--threads" && i+1 < argc ) { thread_count = std::stoi( argv[++i] ); }
+        else if ( option == "--denominators" && i+1 < argc ) { denominators = argv[++i]; }
+        else if ( option == "--pipeline" ) { pipeline = true; }
+        else if ( option == "--slide" && i+1 < argc ) { sliding = true; slide_count = std::stoi( argv[++i] ); }
+        else if ( option == "--cache" && i+1 < argc ) { cache_directory_path = argv[++i]; }
+        else if ( option == "--index" && i+1 < argc ) { index = argv[++i]; }
+        else {
+            std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: Invalid option: " << option << std::endl;
+            std::cerr << std::endl;
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+    
+    if ( !validate_arguments( dataset_file_path, first_time_slot, time_slot_count, distance, dts, ps, times, thread_count, denominators, slide_count, index ) ) {
+        return EXIT_FAILURE;
+    }
+    set_spatial_index_kind( index );
 
     std::cout << std::setw( 5 ) << std::left << " " << "dataset_file_path: " << dataset_file_path << std::endl;
     std::cout << std::setw( 5 ) << std::left << " " << "first_time_slot: " << first_time_slot << std::endl;
     std::cout << std::setw( 5 ) << std::left << " " << "time_slot_count: " << time_slot_count << std::endl;
     std::cout << std::setw( 5 ) << std::left << " " << "distance: " << distance << std::endl;
-    std::cout << std::setw( 5 ) << std::left << " " << "dt: " << dt << std::endl;
-    std::cout << std::setw( 5 ) << std::left << " " << "p: " << p << std::endl;
-    std::cout << std::setw( 5 ) << std::left << " " << "time: " << time << std::endl;
+    if ( dts.size() == 1 ) { std::cout << std::setw( 5 ) << std::left << " " << "dt: " << dts.front() << std::endl; }
+    else { std::cout << std::setw( 5 ) << std::left << " " << "dt: " << dts << std::endl; }
+    if ( ps.size() == 1 ) { std::cout << std::setw( 5 ) << std::left << " " << "p: " << ps.front() << std::endl; }
+    else { std::cout << std::setw( 5 ) << std::left << " " << "p: " << ps << std::endl; }
+    if ( times.size() == 1 ) { std::cout << std::setw( 5 ) << std::left << " " << "time: " << times.front() << std::endl; }
+    else { std::cout << std::setw( 5 ) << std::left << " " << "time: " << times << std::endl; }
+    std::cout << std::setw( 5 ) << std::left << " " << "threads: " << thread_count << std::endl;
+    std::cout << std::setw( 5 ) << std::left << " " << "denominators: " << denominators << std::endl;
+    std::cout << std::setw( 5 ) << std::left << " " << "pipeline: " << (pipeline ? "yes" : "no") << std::endl;
+    if ( !cache_directory_path.empty() ) { std::cout << std::setw( 5 ) << std::left << " " << "cache: " << cache_directory_path << std::endl; }
+    std::cout << std::setw( 5 ) << std::left << " " << "index: " << index << std::endl;
     std::cout << std::endl;
     
+    // the neighbor relation of each dt; instances are found for the greatest one, and the ones of the others are the ones of
+    // a small enough diameter
+    std::vector<std::shared_ptr<INeighborRelation>> relations;
+    for ( const float dt : dts ) {
+        if ( distance == "euclidean" ) { relations.push_back( std::make_shared<EuclideanDistance>( dt ) ); }
+        else if ( distance == "latlon" ) { relations.push_back( std::make_shared<LatLonDistance>( dt ) ); }
+        else { relations.push_back( std::make_shared<LatLonChordDistance>( dt ) ); }
+    }
+    const size_t max_dt_index = std::max_element( dts.cbegin(), dts.cend() ) - dts.cbegin();
+    const float dt = dts[max_dt_index];
+    const std::shared_ptr<INeighborRelation> r = relations[max_dt_index];
+    
     // construct dataset
     std::cout << "Constructing dataset from '" << dataset_file_path << "'..." << std::endl;
-    std::ifstream dataset_file ( dataset_file_path );
-    Dataset dataset = construct_dataset( dataset_file );
+    // (only the objects of the requested time slots are kept, including the ones the window slides to)
+    Dataset dataset;
+    std::map<TimeSlot, TimeSlotTables> time_slot_tables;
+    try {
+        const std::pair<TimeSlot, unsigned> window = { (TimeSlot) first_time_slot, (unsigned) std::min<long long>( (long long) time_slot_count + slide_count, ~0u ) };
+        if ( !pipeline || !construct_dataset_pipelined( dataset_file_path, (unsigned) thread_count, window, r, dataset, time_slot_tables ) ) {
+            if ( pipeline ) { std::cout << std::setw( 5 ) << std::left << " " << "Can't pipeline the dataset, reading it before mining..." << std::endl; }
+            dataset = construct_dataset( dataset_file_path, (unsigned) thread_count, window );
+        }
+    }
+    catch ( const std::exception& e ) {
+        std::cerr << std::setw( 5 ) << std::left << " " << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
     print_dataset_info( dataset );
     std::cout << std::endl;
     
     // re-validate time slots arguments after dataset parsing
     std::cout << "Clamping time slots..." << std::endl;
-    int dataset_time_slot_count = (int) dataset.objects_by_time_slot.size();
+    int dataset_time_slot_count = (int) dataset.time_slot_count;
     first_time_slot = std::min( first_time_slot, dataset_time_slot_count-1 );
     time_slot_count = std::min( time_slot_count, dataset_time_slot_count-first_time_slot );
     std::cout << std::setw( 5 ) << std::left << " " << "first_time_slot: " << first_time_slot << std::endl;
     std::cout << std::setw( 5 ) << std::left << " " << "time_slot_count: " << time_slot_count << std::endl;
+    if ( sliding ) {
+        slide_count = std::min( slide_count, dataset_time_slot_count-first_time_slot-time_slot_count );
+        std::cout << std::setw( 5 ) << std::left << " " << "slide: " << slide_count << std::endl;
+    }
     std::cout << std::endl;
     
-    std::shared_ptr<INeighborRelation> r;
-    if ( distance == "euclidean" ) { r = std::make_shared<EuclideanDistance>( dt ); }
-    else { r = std::make_shared<LatLonDistance>( dt ); }
+    // every pair of thresholds is mined, for every dt
+    const bool sweeping = dts.size() > 1 || ps.size() > 1 || times.size() > 1;
+    std::vector<std::pair<float, float>> thresholds;
+    for ( const float p : ps ) {
+        for ( const float time : times ) { thresholds.emplace_back( p, time ); }
+    }
+    
+    // the cache and sweeps are handled by the sliding window miner, which also mines a single window
+    if ( sliding || !cache_directory_path.empty() || sweeping ) {
+        // run the algorithm on each window and print results
+        SlidingWindowMiner miner( dataset, r, ps.front(), times.front(), (unsigned) thread_count );
+        if ( dts.size() > 1 ) { miner.record_diameters = true; }
+        else { miner.add_time_slot_tables( std::move( time_slot_tables ) ); }
+        if ( !cache_directory_path.empty() ) { miner.cache = std::make_shared<PrevalenceCache>( cache_directory_path, distance, dt ); }
+        for ( int slide = 0; slide <= slide_count; ++slide ) {
+            const std::pair<TimeSlot, unsigned> window = { (TimeSlot) (first_time_slot+slide), (unsigned) time_slot_count };
+            std::cout << "Mining time slots " << window.first << ".." << window.first+window.second-1 << "..." << std::endl;
+            
+            const std::vector<std::map<size_t, std::set<Pattern>>> cmdps =
+                miner.mine( window, denominators == "window" ? window_object_count_by_event_type( dataset, window ) : dataset.object_count_by_event_type,
+                            thresholds, relations );
+            std::cout << std::setw( 5 ) << std::left << " " << "joins: " << miner.join_count << std::endl;
+            print_bounding_box_info( *r );
+            std::cout << std::endl;
+            
+            for ( size_t i = 0; i < cmdps.size(); ++i ) {
+                const std::pair<float, float>& pair = thresholds[i % thresholds.size()];
+                if ( sweeping ) { std::cout << "dt=" << dts[i / thresholds.size()] << ", p=" << pair.first << ", time=" << pair.second << ":" << std::endl; }
+                print_results( dataset.event_type_dictionary, cmdps[i] );
+                std::cout << std::endl;
+            }
+        }
+        
+        if ( miner.cache ) {
+            const PrevalenceCache& cache = *miner.cache;
+            std::cout << "Cache: " << std::endl;
+            std::cout << std::setw( 5 ) << std::left << " " << "hits: " << cache.hit_count << std::endl;
+            std::cout << std::setw( 5 ) << std::left << " " << "misses: " << cache.miss_count << std::endl;
+            std::cout << std::setw( 5 ) << std::left << " " << "bytes read: " << cache.read_byte_count << std::endl;
+            std::cout << std::setw( 5 ) << std::left << " " << "bytes written: " << cache.written_byte_count << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+    
+    if ( denominators == "window" ) { restrict_denominators_to_window( dataset, { (TimeSlot) first_time_slot, (unsigned) time_slot_count } ); }
     
     // run the algorithm and print results
     std::cout << "Starting ClosedMDCOP-Miner..." << std::endl;
     std::map<size_t, std::set<Pattern>> cmdp = mine_closed_mdcops( dataset.event_types, dataset,
                                                                    { (TimeSlot) first_time_slot, (unsigned) time_slot_count },
-                                                                   r, p, time );
+                                                                   r, ps.front(), times.front(), (unsigned) thread_count,
+                                                                   std::move( time_slot_tables ) );
+    print_bounding_box_info( *r );
     std::cout << std::endl;
 
-    if ( cmdp.size() == 0 ) {
-        std::cout << "No Closed Mixed-Drove Spatiotemporal Co-Occurrence Patterns found." << std::endl;
-    }
-    else {
-        std::cout << "Closed Mixed-Drove Spatiotemporal Co-Occurrence Patterns: " << std::endl;
-        for ( const auto& pair : cmdp ) {
-            const size_t size = pair.first;
-            const std::set<Pattern>& patterns = pair.second;
-            std::cout << std::setw( 5 ) << std::left << " " << "size=" << size << " (" << patterns.size() << "): " << patterns << std::endl;
-        }
-    }
+    print_results( dataset.event_type_dictionary, cmdp );
     
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,43 @@
+#include <cstddef>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAVE_MMAP
+#endif
+
+#include "mapped_file.hpp"
+
+
+MappedFile::MappedFile(const std::string& file_path) : mapped( false ), data( nullptr ), size( 0 ) {
+#ifdef HAVE_MMAP
+    const int fd = open( file_path.c_str(), O_RDONLY );
+    if ( fd < 0 ) { return; }
+    
+    struct stat status;
+    if ( fstat( fd, &status ) == 0 && S_ISREG( status.st_mode ) ) {
+        if ( status.st_size == 0 ) { mapped = true; }  // nothing to map
+        else {
+            void* address = mmap( nullptr, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if ( address != MAP_FAILED ) {
+                // files are scanned front to back once
+                madvise( address, (size_t) status.st_size, MADV_SEQUENTIAL );
+                
+                mapped = true;
+                data = static_cast<const char*>( address );
+                size = (size_t) status.st_size;
+            }
+        }
+    }
+    close( fd );
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef HAVE_MMAP
+    if ( data ) { munmap( const_cast<char*>( data ), size ); }
+#endif
+}
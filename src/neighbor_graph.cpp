@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "distances.hpp"
+#include "neighbor_graph.hpp"
+#include "neighbor_kernels.hpp"
+#include "object.hpp"
+#include "object_store.hpp"
+#include "pattern.hpp"
+#include "spatial_index.hpp"
+
+
+NeighborGraph::NeighborGraph(const ObjectStore& st, const TimeSlot time_slot, const std::shared_ptr<INeighborRelation> r) :
+    NeighborGraph( st, time_slot, r, 0 ) {}
+
+template<typename Relation>
+void add_neighbors(NeighborGraph& graph, const ObjectStore& st, const TimeSlot time_slot, const Relation& relation,
+                   const std::shared_ptr<ISpatialIndex> index, const ObjectIndex first_object, const bool with_separations) {
+    // the rows of the objects of the time slot, testing pairs with the kernel of relation (see VirtualNeighborRelation)
+    const ObjectRange st_objects = st.time_slot_range( time_slot );
+    const typename Relation::Kernel kernel = relation.kernel( st, st_objects );
+    const std::vector<std::pair<EventType, ObjectRange>> event_type_ranges = st.event_type_ranges( time_slot );
+    const GridIndex* const grid = dynamic_cast<const GridIndex*>( index.get() );
+    const KDTreeIndex* const tree = dynamic_cast<const KDTreeIndex*>( index.get() );
+    const GeodesicCellIndex* const geodesic_cells = dynamic_cast<const GeodesicCellIndex*>( index.get() );
+    
+    std::vector<size_t>& offsets = graph.offsets;
+    std::vector<ObjectIndex>& neighbors = graph.neighbors;
+    std::vector<float>& separations = graph.separations;
+    offsets.reserve( graph.objects.second-graph.objects.first+1 );
+    offsets.push_back( 0 );
+    std::vector<ObjectIndex> candidates;
+    for ( auto i = event_type_ranges.cbegin(); i != event_type_ranges.cend(); ++i ) {
+        const ObjectRange& rows1 = (*i).second;
+        
+        for ( ObjectIndex object1 = rows1.first; object1 < rows1.second; ++object1 ) {
+            if ( index ) {
+                for ( auto j = std::next( i ); j != event_type_ranges.cend(); ++j ) {
+                    const EventType event_type2 = (*j).first;
+                    
+                    candidates.clear();
+                    if ( grid ) { grid->neighbors( object1, event_type2, kernel, candidates ); }
+                    else if ( tree ) { tree->neighbors( object1, event_type2, kernel, candidates ); }
+                    else if ( geodesic_cells ) { geodesic_cells->neighbors( object1, event_type2, kernel, candidates ); }
+                    else { index->neighbors( object1, event_type2, candidates ); }
+                    std::sort( candidates.begin(), candidates.end() );
+                    for ( const ObjectIndex object2 : candidates ) { neighbors.push_back( object2 + first_object ); }
+                }
+            }
+            else {
+                // the objects after the ones of the event type of object1 are tested a block at a time
+                for ( ObjectIndex first2 = rows1.second; first2 < st_objects.second; first2 += NEIGHBOR_BLOCK_SIZE ) {
+                    const unsigned count = (unsigned) std::min<ObjectIndex>( NEIGHBOR_BLOCK_SIZE, st_objects.second-first2 );
+                    for ( uint64_t mask = kernel.neighbors( object1, first2, count ); mask; mask &= mask-1 ) {
+                        neighbors.push_back( first2 + lowest_bit64( mask ) + first_object );
+                    }
+                }
+            }
+            
+            if ( with_separations ) {
+                for ( size_t n = separations.size(); n < neighbors.size(); ++n ) {
+                    separations.push_back( kernel.separation( object1, neighbors[n] - first_object ) );
+                }
+            }
+            
+            offsets.push_back( neighbors.size() );
+        }
+    }
+}
+
+NeighborGraph::NeighborGraph(const ObjectStore& st, const TimeSlot time_slot, const std::shared_ptr<INeighborRelation> r,
+                             const ObjectIndex first_object, const bool with_separations) :
+    objects( st.time_slot_range( time_slot ).first + first_object, st.time_slot_range( time_slot ).second + first_object ) {
+    assert( first_object == 0 || st.ranges_by_time_slot.size() == 1 );
+    
+    // each pair of objects is tested exactly once, from the object with the smaller event type; the relation is looked up once here,
+    // so that testing pairs of the distances known in advance doesn't need a virtual call for each pair
+    const std::shared_ptr<ISpatialIndex> index = construct_spatial_index( st, st.time_slot_range( time_slot ), r );
+    if ( const EuclideanDistance* const euclidean = dynamic_cast<const EuclideanDistance*>( r.get() ) ) {
+        add_neighbors( *this, st, time_slot, *euclidean, index, first_object, with_separations );
+    }
+    else if ( const LatLonDistance* const latlon = dynamic_cast<const LatLonDistance*>( r.get() ) ) {
+        add_neighbors( *this, st, time_slot, *latlon, index, first_object, with_separations );
+    }
+    else if ( const LatLonChordDistance* const latlon_chord = dynamic_cast<const LatLonChordDistance*>( r.get() ) ) {
+        add_neighbors( *this, st, time_slot, *latlon_chord, index, first_object, with_separations );
+    }
+    else { add_neighbors( *this, st, time_slot, VirtualNeighborRelation( *r ), index, first_object, with_separations ); }
+}
+
+std::pair<const ObjectIndex*, const ObjectIndex*> NeighborGraph::neighbors_of(ObjectIndex object) const {
+    assert( object >= objects.first && object < objects.second );
+    
+    const size_t row = object - objects.first;
+    return { neighbors.data() + offsets[row], neighbors.data() + offsets[row+1] };
+}
@@ -0,0 +1,174 @@
+#include <cstdint>
+#include <string>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+
+#include "neighbor_kernels.hpp"
+
+
+uint64_t euclidean_neighbors_scalar(float x, float y, const float* xs, const float* ys, unsigned count, float squared_dt) {
+    uint64_t mask = 0;
+    for ( unsigned i = 0; i < count; ++i ) {
+        const float dx = x-xs[i];
+        const float dy = y-ys[i];
+        if ( dx*dx + dy*dy <= squared_dt ) { mask |= uint64_t( 1 ) << i; }
+    }
+    return mask;
+}
+
+uint64_t chord_neighbors_scalar(double x, double y, double z, const double* xs, const double* ys, const double* zs, unsigned count,
+                                float squared_chord) {
+    uint64_t mask = 0;
+    for ( unsigned i = 0; i < count; ++i ) {
+        const double dx = x-xs[i];
+        const double dy = y-ys[i];
+        const double dz = z-zs[i];
+        if ( (float) (dx*dx + dy*dy + dz*dz) <= squared_chord ) { mask |= uint64_t( 1 ) << i; }
+    }
+    return mask;
+}
+
+
+#ifdef HAVE_X86_KERNELS
+// the SIMD versions test as many candidates at once as their registers hold, and leave the last few to the scalar versions; they
+// don't use fused multiply-adds, which would round differently than the scalar versions
+
+__attribute__((target("sse2")))
+uint64_t euclidean_neighbors_sse2(float x, float y, const float* xs, const float* ys, unsigned count, float squared_dt) {
+    const __m128 px = _mm_set1_ps( x );
+    const __m128 py = _mm_set1_ps( y );
+    const __m128 threshold = _mm_set1_ps( squared_dt );
+    
+    uint64_t mask = 0;
+    unsigned i = 0;
+    for ( ; i+4 <= count; i += 4 ) {
+        const __m128 dx = _mm_sub_ps( px, _mm_loadu_ps( xs+i ) );
+        const __m128 dy = _mm_sub_ps( py, _mm_loadu_ps( ys+i ) );
+        const __m128 squared_distances = _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) );
+        mask |= (uint64_t) _mm_movemask_ps( _mm_cmple_ps( squared_distances, threshold ) ) << i;
+    }
+    if ( i < count ) { mask |= euclidean_neighbors_scalar( x, y, xs+i, ys+i, count-i, squared_dt ) << i; }
+    return mask;
+}
+
+__attribute__((target("sse2")))
+uint64_t chord_neighbors_sse2(double x, double y, double z, const double* xs, const double* ys, const double* zs, unsigned count,
+                              float squared_chord) {
+    const __m128d px = _mm_set1_pd( x );
+    const __m128d py = _mm_set1_pd( y );
+    const __m128d pz = _mm_set1_pd( z );
+    const __m128 threshold = _mm_set1_ps( squared_chord );
+    
+    uint64_t mask = 0;
+    unsigned i = 0;
+    for ( ; i+2 <= count; i += 2 ) {
+        const __m128d dx = _mm_sub_pd( px, _mm_loadu_pd( xs+i ) );
+        const __m128d dy = _mm_sub_pd( py, _mm_loadu_pd( ys+i ) );
+        const __m128d dz = _mm_sub_pd( pz, _mm_loadu_pd( zs+i ) );
+        const __m128d squared_chords = _mm_add_pd( _mm_add_pd( _mm_mul_pd( dx, dx ), _mm_mul_pd( dy, dy ) ), _mm_mul_pd( dz, dz ) );
+        mask |= (uint64_t) (_mm_movemask_ps( _mm_cmple_ps( _mm_cvtpd_ps( squared_chords ), threshold ) ) & 0x3) << i;
+    }
+    if ( i < count ) { mask |= chord_neighbors_scalar( x, y, z, xs+i, ys+i, zs+i, count-i, squared_chord ) << i; }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+uint64_t euclidean_neighbors_avx2(float x, float y, const float* xs, const float* ys, unsigned count, float squared_dt) {
+    const __m256 px = _mm256_set1_ps( x );
+    const __m256 py = _mm256_set1_ps( y );
+    const __m256 threshold = _mm256_set1_ps( squared_dt );
+    
+    uint64_t mask = 0;
+    unsigned i = 0;
+    for ( ; i+8 <= count; i += 8 ) {
+        const __m256 dx = _mm256_sub_ps( px, _mm256_loadu_ps( xs+i ) );
+        const __m256 dy = _mm256_sub_ps( py, _mm256_loadu_ps( ys+i ) );
+        const __m256 squared_distances = _mm256_add_ps( _mm256_mul_ps( dx, dx ), _mm256_mul_ps( dy, dy ) );
+        mask |= (uint64_t) _mm256_movemask_ps( _mm256_cmp_ps( squared_distances, threshold, _CMP_LE_OQ ) ) << i;
+    }
+    if ( i < count ) { mask |= euclidean_neighbors_scalar( x, y, xs+i, ys+i, count-i, squared_dt ) << i; }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+uint64_t chord_neighbors_avx2(double x, double y, double z, const double* xs, const double* ys, const double* zs, unsigned count,
+                              float squared_chord) {
+    const __m256d px = _mm256_set1_pd( x );
+    const __m256d py = _mm256_set1_pd( y );
+    const __m256d pz = _mm256_set1_pd( z );
+    const __m128 threshold = _mm_set1_ps( squared_chord );
+    
+    uint64_t mask = 0;
+    unsigned i = 0;
+    for ( ; i+4 <= count; i += 4 ) {
+        const __m256d dx = _mm256_sub_pd( px, _mm256_loadu_pd( xs+i ) );
+        const __m256d dy = _mm256_sub_pd( py, _mm256_loadu_pd( ys+i ) );
+        const __m256d dz = _mm256_sub_pd( pz, _mm256_loadu_pd( zs+i ) );
+        const __m256d squared_chords = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( dx, dx ), _mm256_mul_pd( dy, dy ) ),
+                                                      _mm256_mul_pd( dz, dz ) );
+        mask |= (uint64_t) _mm_movemask_ps( _mm_cmple_ps( _mm256_cvtpd_ps( squared_chords ), threshold ) ) << i;
+    }
+    if ( i < count ) { mask |= chord_neighbors_scalar( x, y, z, xs+i, ys+i, zs+i, count-i, squared_chord ) << i; }
+    return mask;
+}
+#endif
+
+
+struct NeighborKernels {
+    const char* instruction_set;
+    uint64_t (*euclidean)(float, float, const float*, const float*, unsigned, float);
+    uint64_t (*chord)(double, double, double, const double*, const double*, const double*, unsigned, float);
+};
+
+bool find_neighbor_kernels(const std::string& instruction_set, NeighborKernels& kernels) {
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if ( instruction_set == "avx2" && __builtin_cpu_supports( "avx2" ) ) {
+        kernels = { "avx2", euclidean_neighbors_avx2, chord_neighbors_avx2 };
+        return true;
+    }
+    if ( instruction_set == "sse2" && __builtin_cpu_supports( "sse2" ) ) {
+        kernels = { "sse2", euclidean_neighbors_sse2, chord_neighbors_sse2 };
+        return true;
+    }
+#endif
+    if ( instruction_set == "scalar" ) {
+        kernels = { "scalar", euclidean_neighbors_scalar, chord_neighbors_scalar };
+        return true;
+    }
+    return false;
+}
+
+NeighborKernels& neighbor_kernels() {
+    // the best versions the CPU supports, found once
+    static NeighborKernels kernels = []() {
+        NeighborKernels kernels;
+        for ( const std::string instruction_set : { "avx2", "sse2", "scalar" } ) {
+            if ( find_neighbor_kernels( instruction_set, kernels ) ) { break; }
+        }
+        return kernels;
+    }();
+    return kernels;
+}
+
+
+uint64_t euclidean_neighbors(float x, float y, const float* xs, const float* ys, unsigned count, float squared_dt) {
+    return neighbor_kernels().euclidean( x, y, xs, ys, count, squared_dt );
+}
+
+uint64_t chord_neighbors(double x, double y, double z, const double* xs, const double* ys, const double* zs, unsigned count,
+                         float squared_chord) {
+    return neighbor_kernels().chord( x, y, z, xs, ys, zs, count, squared_chord );
+}
+
+
+const char* neighbor_kernels_instruction_set() {
+    return neighbor_kernels().instruction_set;
+}
+
+bool set_neighbor_kernels_instruction_set(const std::string& instruction_set) {
+    return find_neighbor_kernels( instruction_set, neighbor_kernels() );
+}
@@ -1,5 +1,7 @@
+#include <cassert>
 #include <memory>
 #include <ostream>
+#include <string>
 
 #include "prettyprint.hpp"
 
@@ -11,5 +13,21 @@ Object::Object(EventType event_type, ObjectId id, float x, float y, TimeSlot tim
 }
 
 std::ostream& operator<< (std::ostream& os, const Object& object) {
-    return os << "<" << object.event_type << object.id << ">";
+    return os << "<" << object.event_type << ":" << object.id << ">";
+}
+
+
+EventType EventTypeDictionary::intern(const std::string& name) {
+    const auto i = event_types_by_name.find( name );
+    if ( i != event_types_by_name.end() ) { return (*i).second; }
+    
+    const EventType event_type = (EventType) names.size();
+    names.push_back( name );
+    event_types_by_name.insert( { name, event_type } );
+    return event_type;
+}
+
+const std::string& EventTypeDictionary::name(EventType event_type) const {
+    assert( event_type < names.size() );
+    return names[event_type];
 }
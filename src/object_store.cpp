@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "object.hpp"
+#include "object_store.hpp"
+
+
+ObjectStore::ObjectStore(const std::vector<Object>& objects) {
+    std::vector<EventType> added_event_type;
+    std::vector<ObjectId> added_id;
+    std::vector<float> added_x, added_y;
+    std::vector<TimeSlot> added_time_slot;
+    added_event_type.reserve( objects.size() );
+    added_id.reserve( objects.size() );
+    added_x.reserve( objects.size() );
+    added_y.reserve( objects.size() );
+    added_time_slot.reserve( objects.size() );
+    for ( const Object& object : objects ) {
+        added_event_type.push_back( object.event_type );
+        added_id.push_back( object.id );
+        added_x.push_back( object.x );
+        added_y.push_back( object.y );
+        added_time_slot.push_back( object.time_slot );
+    }
+    
+    *this = ObjectStore( added_event_type, added_id, added_x, added_y, added_time_slot );
+}
+
+ObjectStore::ObjectStore(const std::vector<EventType>& added_event_type, const std::vector<ObjectId>& added_id,
+                         const std::vector<float>& added_x, const std::vector<float>& added_y, const std::vector<TimeSlot>& added_time_slot) {
+    const size_t count = added_event_type.size();
+    assert( added_id.size() == count && added_x.size() == count && added_y.size() == count && added_time_slot.size() == count );
+    
+    // counting sort by (time slot, event type), which keeps the order of the objects with the same key: count the objects of each
+    // key, then place each object after the ones of the smaller keys and the ones with its key added before it
+    // consecutive objects usually share their key, so the last key looked up is remembered
+    const auto key_of = [&](size_t i) { return (uint64_t( added_time_slot[i] ) << 32) | added_event_type[i]; };
+    
+    std::map<uint64_t, size_t> positions_by_key;
+    uint64_t last_key = 0;
+    size_t* last_position = nullptr;
+    for ( size_t i = 0; i < count; ++i ) {
+        const uint64_t key = key_of( i );
+        if ( !last_position || key != last_key ) { last_key = key; last_position = &positions_by_key[key]; }
+        ++*last_position;
+    }
+    size_t position = 0;
+    for ( auto& pair : positions_by_key ) {
+        const size_t key_count = pair.second;
+        pair.second = position;
+        position += key_count;
+        
+        const TimeSlot slot = (TimeSlot) (pair.first >> 32);
+        ObjectRange& range = ranges_by_time_slot[slot];
+        if ( range.first == range.second ) { range.first = (ObjectIndex) pair.second; }
+        range.second = (ObjectIndex) position;
+    }
+    
+    event_type.resize( count );
+    id.resize( count );
+    x.resize( count );
+    y.resize( count );
+    time_slot.resize( count );
+    last_position = nullptr;
+    for ( size_t i = 0; i < count; ++i ) {
+        const uint64_t key = key_of( i );
+        if ( !last_position || key != last_key ) { last_key = key; last_position = &positions_by_key[key]; }
+        
+        const size_t index = (*last_position)++;
+        event_type[index] = added_event_type[i];
+        id[index] = added_id[i];
+        x[index] = added_x[i];
+        y[index] = added_y[i];
+        time_slot[index] = added_time_slot[i];
+    }
+}
+
+Object ObjectStore::object(ObjectIndex index) const {
+    assert( index < size() );
+    return Object( event_type[index], id[index], x[index], y[index], time_slot[index] );
+}
+
+ObjectRange ObjectStore::time_slot_range(TimeSlot slot) const {
+    const auto i = ranges_by_time_slot.find( slot );
+    if ( i == ranges_by_time_slot.end() ) { return { 0, 0 }; }
+    return (*i).second;
+}
+
+ObjectRange ObjectStore::event_type_range(ObjectRange range, EventType type) const {
+    const auto first = event_type.cbegin() + range.first;
+    const auto last = event_type.cbegin() + range.second;
+    const auto bounds = std::equal_range( first, last, type );
+    return { (ObjectIndex) (bounds.first - event_type.cbegin()), (ObjectIndex) (bounds.second - event_type.cbegin()) };
+}
+
+std::vector<std::pair<EventType, ObjectRange>> ObjectStore::event_type_ranges(TimeSlot slot) const {
+    std::vector<std::pair<EventType, ObjectRange>> ranges;
+    
+    const ObjectRange range = time_slot_range( slot );
+    for ( ObjectIndex first = range.first; first < range.second; ) {
+        const ObjectRange type_range = event_type_range( { first, range.second }, event_type[first] );
+        ranges.push_back( { event_type[first], type_range } );
+        first = type_range.second;
+    }
+    return ranges;
+}
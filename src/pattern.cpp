@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <set>
+#include <string>
+
+#include "object.hpp"
+#include "pattern.hpp"
+
+
+const EventType Pattern::NO_EVENT_TYPE;
+
+
+bool Pattern::operator<(const Pattern& other) const {
+    // the sequences of event types of the two patterns are identical up to the lowest event type which belongs to only one of them:
+    // the pattern which has it comes first, unless the other pattern has no greater event types (then the other one is a prefix of it)
+    const size_t word_count = 1 + std::max( words.size(), other.words.size() );
+    for ( size_t i = 0; i < word_count; ++i ) {
+        const uint64_t word1 = i == 0 ? word : (i-1 < words.size() ? words[i-1] : 0);
+        const uint64_t word2 = i == 0 ? other.word : (i-1 < other.words.size() ? other.words[i-1] : 0);
+        if ( word1 == word2 ) { continue; }
+        
+        const unsigned bit = lowest_bit64( word1 ^ word2 );
+        const EventType event_type = (EventType) (64*i + bit);
+        if ( (word1 >> bit) & 1 ) { return other.next( event_type+1 ) != NO_EVENT_TYPE; }
+        else { return next( event_type+1 ) == NO_EVENT_TYPE; }
+    }
+    return false;
+}
+
+std::ostream& operator<<(std::ostream& os, const Pattern& pattern) {
+    os << "{";
+    for ( auto i = pattern.cbegin(); i != pattern.cend(); ++i ) {
+        if ( i != pattern.cbegin() ) { os << ", "; }
+        os << *i;
+    }
+    return os << "}";
+}
+
+std::set<std::set<std::string>> pattern_names(const EventTypeDictionary& dictionary, const std::set<Pattern>& patterns) {
+    // translate event types back to their names, sorting patterns as the names are sorted
+    std::set<std::set<std::string>> names;
+    for ( const Pattern& pattern : patterns ) {
+        std::set<std::string> pattern_names;
+        for ( const EventType event_type : pattern ) { pattern_names.insert( dictionary.name( event_type ) ); }
+        names.insert( pattern_names );
+    }
+    return names;
+}
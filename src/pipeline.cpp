@@ -0,0 +1,222 @@
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "algorithm.hpp"
+#include "binary_dataset.hpp"
+#include "bounded_queue.hpp"
+#include "dataset.hpp"
+#include "distances.hpp"
+#include "mapped_file.hpp"
+#include "neighbor_graph.hpp"
+#include "object.hpp"
+#include "object_store.hpp"
+#include "pattern.hpp"
+#include "pipeline.hpp"
+#include "table_instance.hpp"
+
+
+namespace {
+    struct TimeSlotObjects {
+        // the objects of the window read for a time slot, in file order
+        TimeSlot time_slot;
+        ObjectIndex first_object;  // the index of the first one in the dataset
+        std::vector<EventType> event_type;
+        std::vector<ObjectId> id;
+        std::vector<float> x, y;
+    };
+    
+    TimeSlotTables construct_time_slot_tables(const ObjectStore& st, const TimeSlot time_slot, const ObjectIndex first_object,
+                                              const std::shared_ptr<INeighborRelation> r) {
+        // st holds the objects of the time slot alone, but tables refer to objects by their index in the dataset
+        TimeSlotTables tables;
+        tables.graph = std::make_shared<NeighborGraph>( st, time_slot, r, first_object );
+        
+        // the instances of the patterns of size 1 are the objects of each event type, as mine_closed_mdcops builds them
+        std::vector<std::pair<EventType, TableInstance>> size1_tables;
+        for ( const auto& pair : st.event_type_ranges( time_slot ) ) {
+            TableInstance table( 0 );
+            for ( ObjectIndex object = pair.second.first; object < pair.second.second; ++object ) { table.last_objects.push_back( first_object + object ); }
+            table.close_group( nullptr );
+            size1_tables.emplace_back( pair.first, std::move( table ) );
+        }
+        
+        // the patterns of size 2 with an event type without objects in the time slot have no instances
+        for ( size_t i = 0; i < size1_tables.size(); ++i ) {
+            for ( size_t j = i+1; j < size1_tables.size(); ++j ) {
+                TableInstance table = join( size1_tables[i].second, size1_tables[j].second, *tables.graph );
+                if ( !table.empty() ) { tables.size2_tables.emplace( Pattern{ size1_tables[i].first, size1_tables[j].first }, std::move( table ) ); }
+            }
+        }
+        return tables;
+    }
+}
+
+
+bool construct_dataset_pipelined(const std::string& dataset_file_path, const unsigned thread_count, const std::pair<TimeSlot, unsigned> window,
+                                 const std::shared_ptr<INeighborRelation> r, Dataset& dataset, std::map<TimeSlot, TimeSlotTables>& tables) {
+    assert( thread_count > 0 );
+    
+    const MappedFile file( dataset_file_path );
+    if ( file.mapped && is_binary_dataset( file ) ) { return false; }
+    std::ifstream dataset_file;
+    if ( !file.mapped ) { dataset_file.open( dataset_file_path ); }
+    
+    // the calling thread reads the file and pushes the objects of each time slot to a queue as soon as the file moves on to the next
+    // one; the queue is bounded, so that reading waits for the threads computing the tables when it gets too far ahead of them
+    BoundedQueue<TimeSlotObjects> queue( 2*thread_count );
+    
+    std::mutex results_mutex;
+    std::map<TimeSlot, ObjectStore> stores;  // the objects of each time slot, sorted as in the dataset
+    std::map<TimeSlot, TimeSlotTables> time_slot_tables;
+    std::exception_ptr exception;  // the first exception thrown by a thread
+    
+    std::vector<std::thread> threads;
+    for ( unsigned i = 0; i < thread_count; ++i ) {
+        threads.emplace_back( [&]() {
+            // keep on popping after an exception, so that reading is never stuck on a full queue
+            TimeSlotObjects objects;
+            while ( queue.pop( objects ) ) {
+                try {
+                    const TimeSlot time_slot = objects.time_slot;
+                    ObjectStore st( objects.event_type, objects.id, objects.x, objects.y,
+                                    std::vector<TimeSlot>( objects.event_type.size(), time_slot ) );
+                    TimeSlotTables tables = construct_time_slot_tables( st, time_slot, objects.first_object, r );
+                    objects = TimeSlotObjects();
+                    
+                    std::lock_guard<std::mutex> lock( results_mutex );
+                    stores.emplace( time_slot, std::move( st ) );
+                    time_slot_tables.emplace( time_slot, std::move( tables ) );
+                }
+                catch ( ... ) {
+                    std::lock_guard<std::mutex> lock( results_mutex );
+                    if ( !exception ) { exception = std::current_exception(); }
+                }
+            }
+        } );
+    }
+    
+    // as construct_dataset, all objects are counted and all time slots are counted, but only the objects of the window are kept
+    EventTypeDictionary event_type_dictionary;
+    std::vector<size_t> object_count_by_event_type;
+    size_t time_slot_count = 0;
+    ObjectIndex object_count = 0;  // of the window
+    
+    TimeSlotObjects objects;
+    TimeSlot current_time_slot = 0;
+    const auto push_time_slot = [&]() {
+        if ( objects.event_type.empty() ) { return; }
+        objects.time_slot = current_time_slot;
+        objects.first_object = object_count;
+        object_count += (ObjectIndex) objects.event_type.size();
+        queue.push( std::move( objects ) );
+        objects = TimeSlotObjects();
+    };
+    
+    std::string event_type_name;
+    EventType event_type = 0;
+    // false if the time slot of the line is before the current one
+    const auto read_line = [&](const char* line, const char* line_end) {
+        std::pair<const char*, const char*> name;
+        float x, y;
+        TimeSlot time_slot;
+        // check if the line is well-formed, otherwise skip it
+        if ( !parse_line( line, line_end, name, x, y, time_slot ) ) { return true; }
+        
+        // (lines of the same event type often come in runs, see construct_dataset)
+        const size_t name_size = name.second - name.first;
+        if ( event_type_name.size() != name_size || event_type_name.compare( 0, name_size, name.first, name_size ) != 0 ) {
+            event_type_name.assign( name.first, name_size );
+            event_type = event_type_dictionary.intern( event_type_name );
+            if ( event_type == object_count_by_event_type.size() ) { object_count_by_event_type.push_back( 0 ); }
+        }
+        const ObjectId id = (ObjectId) object_count_by_event_type[event_type]++;
+        
+        if ( time_slot_count == 0 || time_slot != current_time_slot ) {
+            if ( time_slot_count > 0 && time_slot < current_time_slot ) { return false; }
+            push_time_slot();
+            current_time_slot = time_slot;
+            ++time_slot_count;
+        }
+        
+        if ( time_slot < window.first || time_slot-window.first >= window.second ) { return true; }
+        objects.event_type.push_back( event_type );
+        objects.id.push_back( id );
+        objects.x.push_back( x );
+        objects.y.push_back( y );
+        return true;
+    };
+    
+    bool sorted = true;
+    try {
+        if ( file.mapped ) {
+            const char* const file_end = file.data + file.size;
+            for ( const char* line = file.data, *next_line; sorted && line != file_end; line = next_line ) {
+                const char* line_end = static_cast<const char*>( std::memchr( line, '\n', file_end-line ) );
+                if ( !line_end ) { line_end = file_end; }
+                next_line = line_end == file_end ? file_end : line_end+1;
+                
+                sorted = read_line( line, line_end );
+            }
+        }
+        else {
+            std::string line;
+            while ( sorted && std::getline( dataset_file, line ) ) { sorted = read_line( line.data(), line.data() + line.size() ); }
+        }
+        if ( sorted ) { push_time_slot(); }
+    }
+    catch ( ... ) {
+        std::lock_guard<std::mutex> lock( results_mutex );
+        if ( !exception ) { exception = std::current_exception(); }
+    }
+    
+    queue.close();
+    for ( std::thread& thread : threads ) { thread.join(); }
+    if ( exception ) { std::rethrow_exception( exception ); }
+    
+    if ( !sorted ) { return false; }
+    // a window starting after the last time slot is clamped to the last time slot, which was not kept
+    const std::pair<TimeSlot, unsigned> clamped_window = clamp_time_slots( window, time_slot_count );
+    if ( clamped_window.second > 0 && clamped_window.first < window.first ) { return false; }
+    
+    // time slots follow each other in the file, so the objects of each one go right after the ones of the time slots before it
+    Dataset pipelined_dataset = Dataset();
+    pipelined_dataset.event_type_dictionary = std::move( event_type_dictionary );
+    for ( EventType event_type = 0; event_type < object_count_by_event_type.size(); ++event_type ) { pipelined_dataset.event_types.insert( event_type ); }
+    pipelined_dataset.object_count_by_event_type = std::move( object_count_by_event_type );
+    pipelined_dataset.time_slot_count = time_slot_count;
+    
+    ObjectStore& st = pipelined_dataset.objects;
+    st.event_type.reserve( object_count );
+    st.id.reserve( object_count );
+    st.x.reserve( object_count );
+    st.y.reserve( object_count );
+    st.time_slot.reserve( object_count );
+    for ( auto& pair : stores ) {
+        const ObjectStore& time_slot_st = pair.second;
+        
+        const ObjectIndex first_object = (ObjectIndex) st.size();
+        assert( first_object == (*time_slot_tables.at( pair.first ).graph).objects.first );
+        st.event_type.insert( st.event_type.end(), time_slot_st.event_type.cbegin(), time_slot_st.event_type.cend() );
+        st.id.insert( st.id.end(), time_slot_st.id.cbegin(), time_slot_st.id.cend() );
+        st.x.insert( st.x.end(), time_slot_st.x.cbegin(), time_slot_st.x.cend() );
+        st.y.insert( st.y.end(), time_slot_st.y.cbegin(), time_slot_st.y.cend() );
+        st.time_slot.insert( st.time_slot.end(), time_slot_st.time_slot.cbegin(), time_slot_st.time_slot.cend() );
+        st.ranges_by_time_slot[pair.first] = { first_object, (ObjectIndex) st.size() };
+        
+        pair.second = ObjectStore();
+    }
+    
+    dataset = std::move( pipelined_dataset );
+    tables = std::move( time_slot_tables );
+    return true;
+}
@@ -0,0 +1,159 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#include <sys/types.h>
+#define HAVE_MKDIR
+#endif
+
+#include "dataset.hpp"
+#include "object.hpp"
+#include "object_store.hpp"
+#include "pattern.hpp"
+#include "prevalence_cache.hpp"
+
+
+namespace {
+    const char MAGIC[8] = { 'M', 'D', 'C', 'O', 'P', 'P', 'I', 'C' };
+    const uint32_t VERSION = 1;
+    
+    struct Hash {
+        // 64-bit FNV-1a
+        uint64_t value;
+        
+        Hash() : value( 0xCBF29CE484222325ull ) {}
+        void add(const void* data, size_t size) {
+            const unsigned char* bytes = static_cast<const unsigned char*>( data );
+            for ( size_t i = 0; i < size; ++i ) { value = (value ^ bytes[i]) * 0x100000001B3ull; }
+        }
+        template<typename T>
+        void add(const T& value) { add( &value, sizeof( T ) ); }
+    };
+    
+    std::string file_path(const std::string& directory_path, uint64_t key) {
+        std::ostringstream file_path;
+        file_path << directory_path << "/" << std::hex << std::setw( 16 ) << std::setfill( '0' ) << key << ".bin";
+        return file_path.str();
+    }
+    
+    template<typename T>
+    void write(std::string& data, const T& value) { data.append( reinterpret_cast<const char*>( &value ), sizeof( T ) ); }
+    
+    template<typename T>
+    bool read(const std::string& data, size_t& offset, T& value) {
+        if ( sizeof( T ) > data.size() || offset > data.size()-sizeof( T ) ) { return false; }
+        std::memcpy( &value, data.data() + offset, sizeof( T ) );
+        offset += sizeof( T );
+        return true;
+    }
+}
+
+
+PrevalenceCache::PrevalenceCache(const std::string& directory_path, const std::string& distance, const float dt) :
+    directory_path( directory_path ), distance( distance ), dt( dt ), hit_count( 0 ), miss_count( 0 ), read_byte_count( 0 ),
+    written_byte_count( 0 ) {
+#ifdef HAVE_MKDIR
+    mkdir( directory_path.c_str(), 0777 );
+#endif
+}
+
+
+uint64_t PrevalenceCache::key(const Dataset& dataset, const TimeSlot time_slot) const {
+    // the objects of a time slot are hashed in the order of the dataset, i.e. by event type and then in file order, which is the
+    // order the instances of patterns are found in
+    Hash hash;
+    hash.add( distance.data(), distance.size()+1 );
+    hash.add( dt );
+    for ( const std::string& name : dataset.event_type_dictionary.names ) { hash.add( name.c_str(), name.size()+1 ); }
+    
+    const ObjectStore& st = dataset.objects;
+    const ObjectRange objects = st.time_slot_range( time_slot );
+    hash.add( uint64_t( objects.second-objects.first ) );
+    for ( ObjectIndex object = objects.first; object < objects.second; ++object ) {
+        hash.add( st.event_type[object] );
+        hash.add( st.x[object] );
+        hash.add( st.y[object] );
+    }
+    return hash.value;
+}
+
+
+bool PrevalenceCache::load(const uint64_t key, std::map<Pattern, std::vector<size_t>>& partecipating_object_counts) {
+    std::ifstream file( file_path( directory_path, key ), std::ios::binary );
+    const std::string data( (std::istreambuf_iterator<char>( file )), std::istreambuf_iterator<char>() );
+    
+    // files are checked as they are read, and anything unexpected makes them a miss
+    size_t offset = sizeof( MAGIC );
+    uint32_t version;
+    uint64_t file_key, pattern_count;
+    bool valid = data.size() >= sizeof( MAGIC ) && std::memcmp( data.data(), MAGIC, sizeof( MAGIC ) ) == 0;
+    valid = valid && read( data, offset, version ) && version == VERSION && read( data, offset, file_key ) && file_key == key
+                  && read( data, offset, pattern_count );
+    
+    std::map<Pattern, std::vector<size_t>> counts;
+    for ( uint64_t i = 0; valid && i < pattern_count; ++i ) {
+        // the event types of the pattern, each followed by its count
+        uint32_t event_type_count;
+        valid = read( data, offset, event_type_count ) && event_type_count > 0 && event_type_count <= data.size();
+        
+        Pattern pattern;
+        std::vector<size_t> pattern_counts;
+        for ( uint32_t j = 0; valid && j < event_type_count; ++j ) {
+            uint32_t event_type;
+            uint64_t count;
+            valid = read( data, offset, event_type ) && read( data, offset, count );
+            pattern.insert( event_type );
+            pattern_counts.push_back( (size_t) count );
+        }
+        valid = valid && pattern.size() == event_type_count;
+        if ( valid ) { counts.emplace_hint( counts.cend(), pattern, pattern_counts ); }
+    }
+    valid = valid && offset == data.size();
+    
+    if ( !valid ) {
+        ++miss_count;
+        return false;
+    }
+    ++hit_count;
+    read_byte_count += data.size();
+    partecipating_object_counts.insert( counts.cbegin(), counts.cend() );
+    return true;
+}
+
+bool PrevalenceCache::store(const uint64_t key, const std::map<Pattern, std::vector<size_t>>& partecipating_object_counts) {
+    std::string data( MAGIC, sizeof( MAGIC ) );
+    write( data, VERSION );
+    write( data, key );
+    write( data, uint64_t( partecipating_object_counts.size() ) );
+    for ( const auto& pair : partecipating_object_counts ) {
+        write( data, uint32_t( pair.first.size() ) );
+        auto count = pair.second.cbegin();
+        for ( const EventType event_type : pair.first ) {
+            write( data, uint32_t( event_type ) );
+            write( data, uint64_t( *count++ ) );
+        }
+    }
+    
+    // the file is written under a temporary name and then renamed, so that no run ever reads a partially written file
+    const std::string cache_file_path = file_path( directory_path, key );
+    const std::string temporary_file_path = cache_file_path + ".tmp";
+    {
+        std::ofstream file( temporary_file_path, std::ios::binary | std::ios::trunc );
+        if ( !file.write( data.data(), data.size() ) ) { return false; }
+    }
+    if ( std::rename( temporary_file_path.c_str(), cache_file_path.c_str() ) != 0 ) {
+        std::remove( temporary_file_path.c_str() );
+        return false;
+    }
+    written_byte_count += data.size();
+    return true;
+}
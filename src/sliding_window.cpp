@@ -0,0 +1,255 @@
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "algorithm.hpp"
+#include "dataset.hpp"
+#include "distances.hpp"
+#include "neighbor_graph.hpp"
+#include "object.hpp"
+#include "object_store.hpp"
+#include "pattern.hpp"
+#include "prevalence_cache.hpp"
+#include "sliding_window.hpp"
+#include "table_instance.hpp"
+#include "thread_pool.hpp"
+
+
+SlidingWindowMiner::SlidingWindowMiner(const Dataset& st, const std::shared_ptr<INeighborRelation> r, const float p, const float time,
+                                       const unsigned thread_count) :
+    st( st ), r( r ), p( p ), time( time ), thread_count( thread_count ), record_diameters( false ), join_count( 0 ) {
+    assert( r );
+    assert( p > 0 && p <= 1 );
+    assert( time > 0 && time <= 1 );
+    assert( thread_count > 0 );
+}
+
+void SlidingWindowMiner::add_time_slot_tables(std::map<TimeSlot, TimeSlotTables> tables) {
+    assert( !record_diameters );  // the tables have no diameters
+    for ( auto& pair : tables ) {
+        TimeSlotState& state = time_slots[pair.first];
+        state.graph = pair.second.graph;
+        for ( auto& pair2 : pair.second.size2_tables ) { state.tables.insert( std::move( pair2 ) ); }
+    }
+}
+
+
+const TableInstance& SlidingWindowMiner::table(const TimeSlot time_slot, const Pattern& pattern) {
+    TimeSlotState& state = time_slots.at( time_slot );
+    
+    const auto i = state.tables.find( pattern );
+    if ( i != state.tables.end() ) { return (*i).second; }
+    
+    TableInstance table;
+    if ( pattern.size() == 1 ) {
+        // a single group with an empty prefix, as mine_closed_mdcops builds it
+        const ObjectRange objects = st.objects.event_type_range( st.objects.time_slot_range( time_slot ), *pattern.cbegin() );
+        for ( ObjectIndex object = objects.first; object < objects.second; ++object ) { table.last_objects.push_back( object ); }
+        table.close_group( nullptr );
+        if ( record_diameters ) { table.diameters.assign( table.last_objects.size(), 0.f ); }
+    }
+    else {
+        // join the two subpatterns apriori_gen generates the pattern from: the pattern without its last event type, and the pattern
+        // without the one before it
+        const EventType last_event_type = pattern.last();
+        const Pattern subpattern1 = pattern.without( last_event_type );
+        const Pattern subpattern2 = pattern.without( subpattern1.last() );
+        if ( !state.graph ) { state.graph = std::make_shared<NeighborGraph>( st.objects, time_slot, r, 0, record_diameters ); }
+        table = join( this->table( time_slot, subpattern1 ), this->table( time_slot, subpattern2 ), *state.graph );
+        ++state.join_count;
+    }
+    return (*state.tables.emplace( pattern, std::move( table ) ).first).second;
+}
+
+const std::vector<size_t>& SlidingWindowMiner::partecipating_object_counts(const TimeSlot time_slot, const Pattern& pattern) {
+    TimeSlotState& state = time_slots.at( time_slot );
+    
+    const auto i = state.partecipating_object_counts.find( pattern );
+    if ( i != state.partecipating_object_counts.end() ) { return (*i).second; }
+    
+    std::vector<size_t> counts = find_partecipating_object_counts( pattern, table( time_slot, pattern ) );
+    return (*state.partecipating_object_counts.emplace( pattern, std::move( counts ) ).first).second;
+}
+
+const std::vector<size_t>& SlidingWindowMiner::partecipating_object_counts(const TimeSlot time_slot, const Pattern& pattern,
+                                                                           const float max_separation) {
+    if ( max_separation == r->max_separation() ) { return partecipating_object_counts( time_slot, pattern ); }
+    assert( record_diameters );
+    assert( max_separation < r->max_separation() );
+    
+    std::map<Pattern, std::vector<size_t>>& partecipating_object_counts =
+        time_slots.at( time_slot ).partecipating_object_counts_by_max_separation[max_separation];
+    
+    const auto i = partecipating_object_counts.find( pattern );
+    if ( i != partecipating_object_counts.end() ) { return (*i).second; }
+    
+    std::vector<size_t> counts = find_partecipating_object_counts( pattern, table( time_slot, pattern ), max_separation );
+    return (*partecipating_object_counts.emplace( pattern, std::move( counts ) ).first).second;
+}
+
+
+std::map<size_t, std::set<Pattern>> SlidingWindowMiner::mine(const std::pair<TimeSlot, unsigned> window,
+                                                             const std::vector<size_t>& object_count_by_event_type) {
+    return mine( window, object_count_by_event_type, { { p, time } } ).front();
+}
+
+std::vector<std::map<size_t, std::set<Pattern>>> SlidingWindowMiner::mine(const std::pair<TimeSlot, unsigned> window,
+                                                                          const std::vector<size_t>& object_count_by_event_type,
+                                                                          const std::vector<std::pair<float, float>>& thresholds) {
+    return mine( window, object_count_by_event_type, thresholds, { r } );
+}
+
+std::vector<std::map<size_t, std::set<Pattern>>> SlidingWindowMiner::mine(const std::pair<TimeSlot, unsigned> window,
+                                                                          const std::vector<size_t>& object_count_by_event_type,
+                                                                          const std::vector<std::pair<float, float>>& thresholds,
+                                                                          const std::vector<std::shared_ptr<INeighborRelation>>& relations) {
+    const TimeSlot first_time_slot = window.first;
+    const unsigned time_slot_count = window.second;
+    assert( time_slot_count > 0 );
+    assert( first_time_slot + time_slot_count <= st.time_slot_count );
+    assert( !thresholds.empty() );
+    assert( !relations.empty() );
+    
+    // forget the time slots which left the window, and look up the ones which entered it in the cache
+    for ( auto i = time_slots.begin(); i != time_slots.end(); ) {
+        const TimeSlot time_slot = (*i).first;
+        
+        if ( time_slot < first_time_slot || time_slot-first_time_slot >= time_slot_count ) { time_slots.erase( i++ ); }
+        else { ++i; }
+    }
+    for ( TimeSlot time_slot = first_time_slot; time_slot < first_time_slot + time_slot_count; ++time_slot ) {
+        TimeSlotState& state = time_slots[time_slot];
+        state.join_count = 0;
+        
+        if ( cache && !state.cache_looked_up ) {
+            state.cache_looked_up = true;
+            state.cache_key = cache->key( st, time_slot );
+            cache->load( state.cache_key, state.partecipating_object_counts );
+            state.cached_pattern_count = state.partecipating_object_counts.size();
+        }
+    }
+    ThreadPool pool( thread_count );
+    
+    // the patterns evaluated with stricter thresholds are a subset of the ones evaluated with the loosest ones (a pattern spatial
+    // prevalent for a p is also spatial prevalent for any smaller p, and so on up to time prevalence), so after mining with the
+    // loosest thresholds the other ones only look up partecipating object counts
+    size_t loosest = 0;
+    for ( size_t i = 1; i < thresholds.size(); ++i ) {
+        if ( thresholds[i].first <= thresholds[loosest].first && thresholds[i].second <= thresholds[loosest].second ) { loosest = i; }
+    }
+    // the instances of each neighbor relation are the ones of the relation of the miner whose diameter is small enough, so they are
+    // all found by the same joins
+    std::map<TimeSlot, std::set<Pattern>> extendable_by_time_slot;  // patterns of any size, for any thresholds
+    std::vector<std::map<size_t, std::set<Pattern>>> cmdps( relations.size() * thresholds.size() );
+    for ( size_t i = 0; i < relations.size(); ++i ) {
+        const float max_separation = relations[i]->max_separation();
+        std::map<size_t, std::set<Pattern>>* const relation_cmdps = cmdps.data() + i*thresholds.size();
+        
+        relation_cmdps[loosest] = mine( window, object_count_by_event_type, thresholds[loosest].first, thresholds[loosest].second,
+                                        max_separation, pool, extendable_by_time_slot );
+        for ( size_t j = 0; j < thresholds.size(); ++j ) {
+            if ( j == loosest ) { continue; }
+            relation_cmdps[j] = mine( window, object_count_by_event_type, thresholds[j].first, thresholds[j].second, max_separation, pool,
+                                      extendable_by_time_slot );
+        }
+    }
+    
+    // keep only the instances that the next windows may extend, and save the time slots whose patterns grew
+    join_count = 0;
+    for ( auto& pair : time_slots ) {
+        TimeSlotState& state = pair.second;
+        join_count += state.join_count;
+        if ( cache && state.partecipating_object_counts.size() > state.cached_pattern_count ) {
+            if ( cache->store( state.cache_key, state.partecipating_object_counts ) ) {
+                state.cached_pattern_count = state.partecipating_object_counts.size();
+            }
+        }
+        
+        const std::set<Pattern>& extendable = extendable_by_time_slot[pair.first];
+        std::map<Pattern, TableInstance>& tables = state.tables;
+        
+        for ( auto i = tables.begin(); i != tables.end(); ) {
+            if ( !extendable.count( (*i).first ) ) { tables.erase( i++ ); }
+            else { ++i; }
+        }
+    }
+    
+    return cmdps;
+}
+
+std::map<size_t, std::set<Pattern>> SlidingWindowMiner::mine(const std::pair<TimeSlot, unsigned> window,
+                                                             const std::vector<size_t>& object_count_by_event_type,
+                                                             const float p, const float time, const float max_separation, ThreadPool& pool,
+                                                             std::map<TimeSlot, std::set<Pattern>>& extendable_by_time_slot) {
+    assert( p > 0 && p <= 1 );
+    assert( time > 0 && time <= 1 );
+    const TimeSlot first_time_slot = window.first;
+    const unsigned time_slot_count = window.second;
+    
+    // the steps of mine_closed_mdcops, where the candidate patterns of size k+1 of a time slot are the ones whose subsets of size k
+    // are all spatial prevalent in it (all event types are, for size 1)
+    size_t k = 1;
+    std::map<size_t, std::set<Pattern>> cmdp;
+    for ( const EventType event_type : st.event_types ) { cmdp[k].insert( Pattern{ event_type } ); }
+    std::map<TimeSlot, std::set<Pattern>> sp_by_time_slot;
+    for ( TimeSlot time_slot = first_time_slot; time_slot < first_time_slot + time_slot_count; ++time_slot ) {
+        sp_by_time_slot[time_slot] = cmdp[k];
+        extendable_by_time_slot[time_slot].insert( cmdp[k].cbegin(), cmdp[k].cend() );
+    }
+    
+    std::map<Pattern, std::vector<float>> spatial_indexes_by_pattern;
+    while ( !cmdp[k].empty() ) {
+        const std::map<Pattern, SubPatterns> candidate_patterns = apriori_gen( cmdp[k] );
+        
+        std::map<Pattern, float> tp;
+        for ( const auto& pair : candidate_patterns ) { tp[pair.first] = 0.f; }
+        
+        // with more than one thread, the candidate patterns of all time slots are evaluated at once (as mine_closed_mdcops does), as
+        // time slots don't share anything; only the ones not evaluated in a previous window need any work
+        if ( thread_count > 1 ) {
+            parallel_for( pool, time_slot_count, [&](size_t i) {
+                const TimeSlot time_slot = first_time_slot + (TimeSlot) i;
+                
+                for ( const auto& pair : candidate_patterns ) {
+                    if ( exist_all_subsets( pair.first, sp_by_time_slot.at( time_slot ) ) ) {
+                        partecipating_object_counts( time_slot, pair.first, max_separation );
+                    }
+                }
+            } );
+        }
+        
+        std::map<TimeSlot, std::set<Pattern>> next_sp_by_time_slot;
+        for ( TimeSlot time_slot = first_time_slot; time_slot < first_time_slot + time_slot_count; ++time_slot ) {
+            // the candidate patterns which can still be time prevalent
+            std::set<Pattern>& sp = next_sp_by_time_slot[time_slot];
+            for ( const auto& pair : candidate_patterns ) {
+                const Pattern& pattern = pair.first;
+                if ( !tp.count( pattern ) || !exist_all_subsets( pattern, sp_by_time_slot.at( time_slot ) ) ) { continue; }
+                
+                const float partecipation_index = find_partecipation_index( object_count_by_event_type, pattern,
+                                                                            partecipating_object_counts( time_slot, pattern, max_separation ) );
+                if ( partecipation_index != std::numeric_limits<float>::max() && partecipation_index >= p ) { sp.insert( pattern ); }
+                spatial_indexes_by_pattern[pattern].push_back( partecipation_index );
+            }
+            
+            find_time_index( tp, sp, time_slot_count );
+            cmdp[k+1] = find_time_prev_co_occ( tp, time, time_slot_count, time_slot-first_time_slot );
+            
+            extendable_by_time_slot[time_slot].insert( sp.cbegin(), sp.cend() );
+        }
+        
+        for ( const Pattern& pattern : cmdp[k+1] ) { prune_non_closed_subsets( cmdp, pattern, spatial_indexes_by_pattern ); }
+        
+        sp_by_time_slot = std::move( next_sp_by_time_slot );
+        ++k;
+    }
+    
+    cmdp.erase( 1 );
+    cmdp.erase( k );  // empty
+    return cmdp;
+}
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "distances.hpp"
+#include "neighbor_kernels.hpp"
+#include "object.hpp"
+#include "object_store.hpp"
+#include "pattern.hpp"
+#include "spatial_index.hpp"
+
+
+GridIndex::GridIndex(const ObjectStore& objects, const ObjectRange range, float dt, const std::shared_ptr<INeighborRelation> r) :
+    // the cells are slightly larger than dt, so that a pair accepted by r despite float rounding is never two cells apart
+    objects( objects ), cell_size( dt * (1 + 1e-4) ), r( r ) {
+    for ( ObjectIndex i = range.first; i < range.second; ++i ) {
+        const uint64_t key = cell_key( cell_coordinate( objects.x[i], cell_size ), cell_coordinate( objects.y[i], cell_size ) );
+        Cell& cell = cells_by_event_type[objects.event_type[i]][key];
+        cell.objects.push_back( i );
+        cell.x.push_back( objects.x[i] );
+        cell.y.push_back( objects.y[i] );
+    }
+}
+
+void GridIndex::neighbors(ObjectIndex object, EventType event_type, std::vector<ObjectIndex>& result) {
+    neighbors( object, event_type, VirtualNeighborRelation( *r ).kernel( objects, { 0, (ObjectIndex) objects.size() } ), result );
+}
+
+void GridIndex::neighbors(ObjectIndex object, EventType event_type, const EuclideanDistance::Kernel& kernel,
+                          std::vector<ObjectIndex>& result) const {
+    const auto i = cells_by_event_type.find( event_type );
+    if ( i == cells_by_event_type.end() ) { return; }
+    const auto& cells = (*i).second;
+    
+    const float x = objects.x[object];
+    const float y = objects.y[object];
+    const int64_t cx = cell_coordinate( x, cell_size );
+    const int64_t cy = cell_coordinate( y, cell_size );
+    for ( int64_t dx = -1; dx <= 1; ++dx ) {
+        for ( int64_t dy = -1; dy <= 1; ++dy ) {
+            const auto j = cells.find( cell_key( cx+dx, cy+dy ) );
+            if ( j == cells.end() ) { continue; }
+            const Cell& cell = (*j).second;
+            
+            for ( size_t first = 0; first < cell.objects.size(); first += NEIGHBOR_BLOCK_SIZE ) {
+                const unsigned count = (unsigned) std::min<size_t>( NEIGHBOR_BLOCK_SIZE, cell.objects.size()-first );
+                uint64_t mask = euclidean_neighbors( x, y, cell.x.data() + first, cell.y.data() + first, count, kernel.r.squared_dt );
+                for ( ; mask; mask &= mask-1 ) { result.push_back( cell.objects[first + lowest_bit64( mask )] ); }
+            }
+        }
+    }
+}
+
+
+
+
+// the nodes of the subtree of the objects tree.objects[first..last), in preorder; returns the index of its root
+static uint32_t build_tree(const ObjectStore& objects, KDTreeIndex::Tree& tree, const uint32_t first, const uint32_t last) {
+    const uint32_t n = (uint32_t) tree.nodes.size();
+    KDTreeIndex::Node node{ objects.x[tree.objects[first]], objects.y[tree.objects[first]],
+                            objects.x[tree.objects[first]], objects.y[tree.objects[first]], first, last, 0 };
+    for ( uint32_t k = first+1; k < last; ++k ) {
+        node.min_x = std::min( node.min_x, objects.x[tree.objects[k]] );
+        node.min_y = std::min( node.min_y, objects.y[tree.objects[k]] );
+        node.max_x = std::max( node.max_x, objects.x[tree.objects[k]] );
+        node.max_y = std::max( node.max_y, objects.y[tree.objects[k]] );
+    }
+    tree.nodes.push_back( node );
+    if ( last-first <= KDTreeIndex::LEAF_SIZE ) { return n; }
+    
+    const std::vector<float>& coordinates = node.max_x-node.min_x >= node.max_y-node.min_y ? objects.x : objects.y;
+    const uint32_t middle = first + (last-first)/2;
+    std::nth_element( tree.objects.begin() + first, tree.objects.begin() + middle, tree.objects.begin() + last,
+                      [&coordinates](ObjectIndex object1, ObjectIndex object2) { return coordinates[object1] < coordinates[object2]; } );
+    build_tree( objects, tree, first, middle );
+    const uint32_t right = build_tree( objects, tree, middle, last );
+    tree.nodes[n].right = right;
+    return n;
+}
+
+KDTreeIndex::KDTreeIndex(const ObjectStore& objects, const ObjectRange range, float dt, const std::shared_ptr<INeighborRelation> r) :
+    // the reach is slightly larger than dt for the same reason as the cells of GridIndex
+    objects( objects ), squared_reach( (float) (dt * (1 + 1e-4) * dt * (1 + 1e-4)) ), r( r ) {
+    for ( ObjectIndex i = range.first; i < range.second; ++i ) { trees_by_event_type[objects.event_type[i]].objects.push_back( i ); }
+    for ( auto& pair : trees_by_event_type ) {
+        Tree& tree = pair.second;
+        build_tree( objects, tree, 0, (uint32_t) tree.objects.size() );
+        for ( const ObjectIndex object : tree.objects ) {
+            tree.x.push_back( objects.x[object] );
+            tree.y.push_back( objects.y[object] );
+        }
+    }
+}
+
+void KDTreeIndex::neighbors(ObjectIndex object, EventType event_type, std::vector<ObjectIndex>& result) {
+    neighbors( object, event_type, VirtualNeighborRelation( *r ).kernel( objects, { 0, (ObjectIndex) objects.size() } ), result );
+}
+
+void KDTreeIndex::neighbors(ObjectIndex object, EventType event_type, const EuclideanDistance::Kernel& kernel,
+                            std::vector<ObjectIndex>& result) const {
+    const float x = objects.x[object];
+    const float y = objects.y[object];
+    visit_leaves( x, y, event_type, [&](const Tree& tree, const Node& leaf) {
+        uint64_t mask = euclidean_neighbors( x, y, tree.x.data() + leaf.first, tree.y.data() + leaf.first, leaf.last-leaf.first,
+                                             kernel.r.squared_dt );
+        for ( ; mask; mask &= mask-1 ) { result.push_back( tree.objects[leaf.first + lowest_bit64( mask )] ); }
+    } );
+}
+
+
+
+
+GeodesicCellIndex::GeodesicCellIndex(const ObjectStore& objects, const ObjectRange range, float dt, const std::shared_ptr<INeighborRelation> r) :
+    objects( objects ), range( range ), box( dt ), r( r ) {
+    // the cells of a band fit the window of longitudes of its latitude farthest from the equator, and are at most 2^24
+    longitude_windows.reserve( range.second-range.first );
+    for ( ObjectIndex i = range.first; i < range.second; ++i ) {
+        longitude_windows.push_back( box.longitude_window( objects.x[i] ) );
+        
+        const uint32_t band_of_object = band( objects.x[i] );
+        auto j = cell_counts_by_band.find( band_of_object );
+        if ( j == cell_counts_by_band.end() ) {
+            const double south = -90 + (double) band_of_object * box.latitude_band;
+            const double north = south + box.latitude_band;
+            const float window = box.longitude_window( (float) std::min( 90., std::max( std::fabs( south ), std::fabs( north ) ) ) );
+            const uint32_t cell_count = window >= 180 ? 1 : (uint32_t) std::max( 1., std::min( std::floor( 360. / window ), 16777216. ) );
+            j = cell_counts_by_band.emplace( band_of_object, cell_count ).first;
+        }
+        
+        const uint32_t cell_of_object = cell( column( objects.y[i], (*j).second ), (*j).second );
+        cells_by_event_type[objects.event_type[i]][cell_key( band_of_object, cell_of_object )].push_back( i );
+    }
+}
+
+uint32_t GeodesicCellIndex::band(float lat) const {
+    const double max_band = std::floor( 180 / box.latitude_band );
+    return (uint32_t) std::min( std::max( std::floor( (lat + 90.) / box.latitude_band ), 0. ), max_band );
+}
+
+double GeodesicCellIndex::candidate_fraction() const {
+    std::unordered_map<uint64_t, size_t> object_counts;
+    for ( const auto& pair : cells_by_event_type ) {
+        for ( const auto& cell : pair.second ) { object_counts[cell.first] += cell.second.size(); }
+    }
+    
+    double candidate_count = 0;
+    for ( ObjectIndex object = range.first; object < range.second; ++object ) {
+        visit_cells( object, [&](uint64_t key) {
+            const auto i = object_counts.find( key );
+            if ( i != object_counts.end() ) { candidate_count += (double) (*i).second; }
+        } );
+    }
+    const double object_count = range.second-range.first;
+    return object_count > 0 ? candidate_count / (object_count*object_count) : 0;
+}
+
+void GeodesicCellIndex::neighbors(ObjectIndex object, EventType event_type, std::vector<ObjectIndex>& result) {
+    neighbors( object, event_type, VirtualNeighborRelation( *r ).kernel( objects, { 0, (ObjectIndex) objects.size() } ), result );
+}
+
+
+static std::string& current_spatial_index_kind() {
+    static std::string kind = "auto";
+    return kind;
+}
+
+const std::string& spatial_index_kind() {
+    return current_spatial_index_kind();
+}
+
+bool set_spatial_index_kind(const std::string& kind) {
+    if ( kind != "grid" && kind != "tree" && kind != "auto" ) { return false; }
+    current_spatial_index_kind() = kind;
+    return true;
+}
+
+// a grid is as fast as a tree only for objects spread evenly over cells which hold many of them: for sparse objects most of the
+// cells it looks up are empty, and clustered objects crowd a few cells whose objects are mostly too far to be neighbors
+static const double GRID_MIN_OBJECTS_PER_CELL = 16;
+static const double GRID_MAX_SKEW = 2;
+
+bool tree_suits(const ObjectStore& objects, const ObjectRange range, float dt) {
+    // the cells of a grid with cells of size dt of the objects, whatever their event type, sorted so that the objects of a cell are
+    // consecutive
+    std::vector<uint64_t> keys;
+    keys.reserve( range.second-range.first );
+    for ( ObjectIndex i = range.first; i < range.second; ++i ) {
+        keys.push_back( cell_key( cell_coordinate( objects.x[i], dt ), cell_coordinate( objects.y[i], dt ) ) );
+    }
+    if ( keys.empty() ) { return false; }
+    std::sort( keys.begin(), keys.end() );
+    
+    // the mean objects of a cell holding any, and of the cell of an object: for objects spread evenly the latter is at most about
+    // one more than the former, for clustered ones it is far greater
+    const double object_count = (double) keys.size();
+    size_t cell_count = 0;
+    double objects_per_cell_of_object = 0;
+    for ( size_t first = 0, last = 0; first < keys.size(); first = last ) {
+        for ( last = first+1; last < keys.size() && keys[last] == keys[first]; ++last ) {}
+        ++cell_count;
+        objects_per_cell_of_object += (double) (last-first) * (last-first) / object_count;
+    }
+    const double objects_per_cell = object_count / cell_count;
+    return objects_per_cell < GRID_MIN_OBJECTS_PER_CELL || objects_per_cell_of_object > GRID_MAX_SKEW * objects_per_cell;
+}
+
+// a pair found through the cells costs about 20 to 30 times one tested by blocks of all pairs (a lookup, a kernel call and a sort
+// of the candidates against a SIMD lane or a bounding box test), so cells only pay off below about 1/32 of the pairs
+static const double GEODESIC_CELLS_MAX_CANDIDATE_FRACTION = 1./32;
+
+std::shared_ptr<ISpatialIndex> construct_spatial_index(const ObjectStore& objects, const ObjectRange range,
+                                                       const std::shared_ptr<INeighborRelation> r) {
+    if ( const std::shared_ptr<EuclideanDistance> euclidean = std::dynamic_pointer_cast<EuclideanDistance>( r ) ) {
+        const std::string& kind = spatial_index_kind();
+        if ( kind == "tree" || (kind == "auto" && tree_suits( objects, range, euclidean->dt )) ) {
+            return std::make_shared<KDTreeIndex>( objects, range, euclidean->dt, r );
+        }
+        return std::make_shared<GridIndex>( objects, range, euclidean->dt, r );
+    }
+    // for the latlon distances, testing all pairs a block at a time is faster than looking up cells unless they leave out most pairs,
+    // as when dt is small compared to the area of the objects
+    std::shared_ptr<GeodesicCellIndex> geodesic_cells;
+    if ( const std::shared_ptr<LatLonDistance> latlon = std::dynamic_pointer_cast<LatLonDistance>( r ) ) {
+        geodesic_cells = std::make_shared<GeodesicCellIndex>( objects, range, latlon->dt, r );
+    }
+    else if ( const std::shared_ptr<LatLonChordDistance> latlon_chord = std::dynamic_pointer_cast<LatLonChordDistance>( r ) ) {
+        geodesic_cells = std::make_shared<GeodesicCellIndex>( objects, range, latlon_chord->dt, r );
+    }
+    if ( geodesic_cells && geodesic_cells->candidate_fraction() <= GEODESIC_CELLS_MAX_CANDIDATE_FRACTION ) { return geodesic_cells; }
+    return nullptr;
+}
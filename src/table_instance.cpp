@@ -0,0 +1,41 @@
+#include <cassert>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "object_store.hpp"
+#include "table_instance.hpp"
+
+
+TableInstance::TableInstance(std::initializer_list<std::pair<std::vector<ObjectIndex>, std::vector<ObjectIndex>>> groups)
+    : TableInstance( groups.size() ? groups.begin()->first.size() : 0 ) {
+    for ( const auto& group : groups ) {
+        assert( group.first.size() == prefix_size );
+        last_objects.insert( last_objects.end(), group.second.cbegin(), group.second.cend() );
+        close_group( group.first.data() );
+    }
+}
+
+
+bool TableInstance::operator==(const TableInstance& other) const {
+    // empty tables are equal whatever their prefix size
+    if ( empty() && other.empty() ) { return true; }
+    return prefix_size == other.prefix_size && prefixes == other.prefixes && offsets == other.offsets && last_objects == other.last_objects;
+}
+
+
+std::ostream& operator<<(std::ostream& os, const TableInstance& table) {
+    // e.g. {{0, 3}: {5, 7}, {1, 4}: {6}}
+    os << "{";
+    for ( size_t group = 0; group < table.group_count(); ++group ) {
+        if ( group ) { os << ", "; }
+        os << "{";
+        for ( size_t i = 0; i < table.prefix_size; ++i ) { os << (i ? ", " : "") << table.prefix( group )[i]; }
+        os << "}: {";
+        for ( const ObjectIndex* object = table.last_objects_begin( group ); object != table.last_objects_end( group ); ++object ) {
+            os << (object != table.last_objects_begin( group ) ? ", " : "") << *object;
+        }
+        os << "}";
+    }
+    return os << "}";
+}
@@ -0,0 +1,137 @@
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+
+namespace {
+    // the pool and the worker of each thread of a pool
+    thread_local const ThreadPool* current_pool = nullptr;
+    thread_local size_t current_pool_worker = 0;
+    
+    void run_task(ThreadPool::Task& task) {
+        try { task.f(); }
+        catch ( ... ) {
+            std::lock_guard<std::mutex> lock( task.group->exception_mutex );
+            if ( !task.group->exception ) { task.group->exception = std::current_exception(); }
+        }
+        --task.group->pending;
+    }
+}
+
+
+ThreadPool::ThreadPool(unsigned thread_count) : thread_count( thread_count ), queued_task_count( 0 ), stopping( false ) {
+    assert( thread_count > 0 );
+    if ( thread_count == 1 ) { return; }
+    
+    for ( unsigned i = 0; i < thread_count; ++i ) { workers.emplace_back( new Worker() ); }
+    for ( unsigned i = 1; i < thread_count; ++i ) {
+        threads.emplace_back( [this, i]() {
+            current_pool = this;
+            current_pool_worker = i;
+            
+            while ( true ) {
+                if ( run_one( i ) ) { continue; }
+                
+                std::unique_lock<std::mutex> lock( sleep_mutex );
+                sleep_condition.wait( lock, [this]() { return stopping || queued_task_count > 0; } );
+                if ( stopping ) { return; }
+            }
+        } );
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock( sleep_mutex );
+        stopping = true;
+    }
+    sleep_condition.notify_all();
+    for ( std::thread& thread : threads ) { thread.join(); }
+}
+
+
+void ThreadPool::run(TaskGroup& group, std::function<void()> f) {
+    ++group.pending;
+    Task task{ &group, std::move( f ) };
+    
+    if ( threads.empty() ) {
+        run_task( task );
+        return;
+    }
+    
+    // counted before being pushed, so that the count never falls behind the tasks that can be popped
+    ++queued_task_count;
+    Worker& worker = *workers[current_worker()];
+    {
+        std::lock_guard<std::mutex> lock( worker.mutex );
+        worker.tasks.push_back( std::move( task ) );
+    }
+    {
+        // the lock orders the push before the check of any worker about to sleep
+        std::lock_guard<std::mutex> lock( sleep_mutex );
+    }
+    sleep_condition.notify_one();
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+    const size_t worker = current_worker();
+    while ( group.pending > 0 ) {
+        if ( threads.empty() || !run_one( worker ) ) { std::this_thread::yield(); }
+    }
+    
+    if ( group.exception ) { std::rethrow_exception( group.exception ); }
+}
+
+
+bool ThreadPool::run_one(size_t worker) {
+    Task task;
+    bool found = false;
+    
+    // the newest task of the worker itself...
+    {
+        Worker& own = *workers[worker];
+        std::lock_guard<std::mutex> lock( own.mutex );
+        if ( !own.tasks.empty() ) {
+            task = std::move( own.tasks.back() );
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    // ...or the oldest task of another worker
+    for ( size_t i = 1; !found && i < workers.size(); ++i ) {
+        Worker& other = *workers[(worker+i) % workers.size()];
+        std::lock_guard<std::mutex> lock( other.mutex );
+        if ( !other.tasks.empty() ) {
+            task = std::move( other.tasks.front() );
+            other.tasks.pop_front();
+            found = true;
+        }
+    }
+    if ( !found ) { return false; }
+    
+    --queued_task_count;
+    run_task( task );
+    return true;
+}
+
+size_t ThreadPool::current_worker() const {
+    return current_pool == this ? current_pool_worker : 0;
+}
+
+
+void parallel_for(ThreadPool& pool, size_t count, const std::function<void(size_t)>& f) {
+    TaskGroup group;
+    for ( size_t i = 0; i < count; ++i ) {
+        pool.run( group, [&f, i]() { f( i ); } );
+    }
+    pool.wait( group );
+}
@@ -1,7 +1,20 @@
 #define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <iostream>
+#include <random>
+#include <stdexcept>
 #include <set>
 #include <map>
+#include <sstream>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -9,15 +22,34 @@
 #include "prettyprint.hpp"
 
 #include "algorithm.hpp"
+#include "binary_dataset.hpp"
+#include "dataset.hpp"
 #include "distances.hpp"
+#include "neighbor_graph.hpp"
 #include "object.hpp"
+#include "object_store.hpp"
+#include "pipeline.hpp"
+#include "prevalence_cache.hpp"
+#include "sliding_window.hpp"
+#include "spatial_index.hpp"
+#include "table_instance.hpp"
+#include "thread_pool.hpp"
+
+
+ObjectIndex index_of(const ObjectStore& objects, EventType event_type, ObjectId id) {
+    for ( ObjectIndex i = 0; i < objects.size(); ++i ) {
+        if ( objects.event_type[i] == event_type && objects.id[i] == id ) { return i; }
+    }
+    FAIL( "no such object" );
+    return 0;
+}
 
 
 bool exist_all_subsets(const Pattern&, const std::set<Pattern>&);
 TEST_CASE( "exist_all_subsets", "[algorithm]" ) {
-    const EventType a{ "A" };
-    const EventType b{ "B" };
-    const EventType c{ "C" };
+    const EventType a{ 0 };
+    const EventType b{ 1 };
+    const EventType c{ 2 };
 
     SECTION( "" ) {
         const Pattern superset_pattern{ a };
@@ -80,10 +112,10 @@ TEST_CASE( "exist_all_subsets", "[algorithm]" ) {
 
 extern std::map<Pattern, SubPatterns> apriori_gen(const std::set<Pattern>&);
 TEST_CASE( "apriori_gen", "[algorithm]" ) {
-    EventType a{ "A" };
-    EventType b{ "B" };
-    EventType c{ "C" };
-    EventType d{ "D" };
+    EventType a{ 0 };
+    EventType b{ 1 };
+    EventType c{ 2 };
+    EventType d{ 3 };
 
     SECTION( "" ) {
         std::set<Pattern> mdp{};
@@ -127,38 +159,128 @@ TEST_CASE( "apriori_gen", "[algorithm]" ) {
         REQUIRE( expected_candidate_patterns == candidate_patterns );
     }
     SECTION( "" ) {
-        std::set<Pattern> mdp{ { "1", "2", "3" }, { "1", "2", "4" }, { "1", "3", "4" }, { "1", "3", "5" }, { "2", "3", "4" } };
+        std::set<Pattern> mdp{ { 1, 2, 3 }, { 1, 2, 4 }, { 1, 3, 4 }, { 1, 3, 5 }, { 2, 3, 4 } };
 
         std::map<Pattern, SubPatterns> candidate_patterns = apriori_gen( mdp );
 
         std::map<Pattern, SubPatterns> expected_candidate_patterns{
-            { { "1", "2", "3", "4" }, { { "1", "2", "3" }, { "1", "2", "4" } } },
+            { { 1, 2, 3, 4 }, { { 1, 2, 3 }, { 1, 2, 4 } } },
         };
         REQUIRE( expected_candidate_patterns == candidate_patterns );
     }
 }
 
 
-extern std::map<Pattern, TableInstance> gen_co_occ_inst(const std::map<Pattern, SubPatterns>&, const std::map<Pattern, TableInstance>&, const std::shared_ptr<INeighborRelation>);
-TEST_CASE( "gen_co_occ_inst", "[algorithm]" ) {
-    const EventType a{ "A" };
-    const EventType b{ "B" };
-    const EventType c{ "C" };
+extern TableInstance join(const TableInstance&, const TableInstance&, const NeighborGraph&);
+extern TableInstance join(const TableInstance&, const TableInstance&, const NeighborGraph&, ThreadPool&);
+TEST_CASE( "join", "[algorithm]" ) {
+    const EventType a{ 0 };
+    const EventType b{ 1 };
+    const EventType c{ 2 };
+
+    const ObjectStore objects( {
+        Object( a, 1, 0, 0, 0 ),
+        Object( a, 2, 10, 0, 0 ),
+        Object( a, 3, 20, 0, 0 ),
+        Object( a, 4, 30, 0, 0 ),
+        Object( b, 1, 0, 1, 0 ),
+        Object( b, 2, 10, 1, 0 ),
+        Object( b, 3, 30, 1, 0 ),
+        Object( c, 1, 0, -1, 0 ),
+        Object( c, 2, 20, -1, 0 ),
+        Object( c, 3, 30, 1.5f, 0 ),
+        Object( c, 4, 30, 2.5f, 0 ),
+    } );
+
+    const ObjectIndex a1 = index_of( objects, a, 1 );
+    const ObjectIndex a2 = index_of( objects, a, 2 );
+    const ObjectIndex a3 = index_of( objects, a, 3 );
+    const ObjectIndex a4 = index_of( objects, a, 4 );
+
+    const ObjectIndex b1 = index_of( objects, b, 1 );
+    const ObjectIndex b2 = index_of( objects, b, 2 );
+    const ObjectIndex b3 = index_of( objects, b, 3 );
+
+    const ObjectIndex c1 = index_of( objects, c, 1 );
+    const ObjectIndex c2 = index_of( objects, c, 2 );
+    const ObjectIndex c3 = index_of( objects, c, 3 );
+    const ObjectIndex c4 = index_of( objects, c, 4 );
+
+    const std::shared_ptr<INeighborRelation> r = std::make_shared<EuclideanDistance>( 1.1f );
+    const NeighborGraph graph( objects, 0, r );
+
+    SECTION( "" ) {
+        // keys present in only one of the two tables are skipped
+        const TableInstance table1{
+            { { a1 }, { b1 } },
+            { { a2 }, { b2 } },
+            { { a4 }, { b3 } },
+        };
+
+        const TableInstance table2{
+            { { a1 }, { c1 } },
+            { { a3 }, { c2 } },
+            { { a4 }, { c3, c4 } },
+        };
+
+        const TableInstance table = join( table1, table2, graph );
+
+        const TableInstance expected_table{
+            { { a4, b3 }, { c3 } },
+        };
+        REQUIRE( expected_table == table );
+    }
+    SECTION( "" ) {
+        const TableInstance table1{
+            { { a1 }, { b1 } },
+        };
+
+        const TableInstance table2{
+            { { a2 }, { c1 } },
+        };
 
-    const std::shared_ptr<Object> a1 = std::make_shared<Object>( a, 1, 1.1f, 1, 0 );
-    const std::shared_ptr<Object> a2 = std::make_shared<Object>( a, 2, 2.8f, 2, 0 );
-    const std::shared_ptr<Object> a3 = std::make_shared<Object>( a, 3, 3.2f, 2, 0 );
-    const std::shared_ptr<Object> a4 = std::make_shared<Object>( a, 4, 2, 3, 0 );
+        const TableInstance table = join( table1, table2, graph );
+
+        REQUIRE( table.empty() );
+    }
+}
 
-    const std::shared_ptr<Object> b1 = std::make_shared<Object>( b, 1, 0, 0.2f, 0 );
-    const std::shared_ptr<Object> b2 = std::make_shared<Object>( b, 2, 5, 0.2f, 0 );
-    const std::shared_ptr<Object> b3 = std::make_shared<Object>( b, 3, 6.5, 2, 0 );
-    const std::shared_ptr<Object> b4 = std::make_shared<Object>( b, 4, 3, 0.5f, 0 );
-    const std::shared_ptr<Object> b5 = std::make_shared<Object>( b, 5, 7, 4, 0 );
 
-    const std::shared_ptr<Object> c1 = std::make_shared<Object>( c, 1, 3.3f, 0.5f, 0 );
-    const std::shared_ptr<Object> c2 = std::make_shared<Object>( c, 2, 0, 2, 0 );
-    const std::shared_ptr<Object> c3 = std::make_shared<Object>( c, 3, 6.7f, 3, 0 );
+extern std::map<Pattern, TableInstance> gen_co_occ_inst(const std::map<Pattern, SubPatterns>&, const std::map<Pattern, TableInstance>&, const NeighborGraph&, ThreadPool&);
+TEST_CASE( "gen_co_occ_inst", "[algorithm]" ) {
+    const EventType a{ 0 };
+    const EventType b{ 1 };
+    const EventType c{ 2 };
+
+    const ObjectStore objects( {
+        Object( a, 1, 1.1f, 1, 0 ),
+        Object( a, 2, 2.8f, 2, 0 ),
+        Object( a, 3, 3.2f, 2, 0 ),
+        Object( a, 4, 2, 3, 0 ),
+        Object( b, 1, 0, 0.2f, 0 ),
+        Object( b, 2, 5, 0.2f, 0 ),
+        Object( b, 3, 6.5, 2, 0 ),
+        Object( b, 4, 3, 0.5f, 0 ),
+        Object( b, 5, 7, 4, 0 ),
+        Object( c, 1, 3.3f, 0.5f, 0 ),
+        Object( c, 2, 0, 2, 0 ),
+        Object( c, 3, 6.7f, 3, 0 ),
+    } );
+
+    const ObjectIndex a1 = index_of( objects, a, 1 );
+    const ObjectIndex a2 = index_of( objects, a, 2 );
+    const ObjectIndex a3 = index_of( objects, a, 3 );
+    const ObjectIndex a4 = index_of( objects, a, 4 );
+
+    const ObjectIndex b1 = index_of( objects, b, 1 );
+    const ObjectIndex b2 = index_of( objects, b, 2 );
+    const ObjectIndex b3 = index_of( objects, b, 3 );
+    const ObjectIndex b4 = index_of( objects, b, 4 );
+    const ObjectIndex b5 = index_of( objects, b, 5 );
+
+    const ObjectIndex c1 = index_of( objects, c, 1 );
+    const ObjectIndex c2 = index_of( objects, c, 2 );
+    const ObjectIndex c3 = index_of( objects, c, 3 );
 
     SECTION( "" ) {
         const TableInstance table4{
@@ -189,25 +311,35 @@ TEST_CASE( "gen_co_occ_inst", "[algorithm]" ) {
         };
 
         const std::shared_ptr<INeighborRelation> r = std::make_shared<EuclideanDistance>( 0.45f );
+        const NeighborGraph graph( objects, 0, r );
 
-        const std::map<Pattern, TableInstance> t = gen_co_occ_inst( candidate_patterns, prev_t, r );
+        ThreadPool pool( 1 );
+        const std::map<Pattern, TableInstance> t = gen_co_occ_inst( candidate_patterns, prev_t, graph, pool );
 
         std::map<Pattern, TableInstance> expected_t;
-        expected_t[{ a, b, c }].insert( { { a3, b4 }, { c1 } } );
+        expected_t[{ a, b, c }] = TableInstance{ { { a3, b4 }, { c1 } } };
         REQUIRE( expected_t == t );
     }
 }
 
 
-extern std::set<Pattern> find_spatial_prev_co_occ(const std::map<EventType, std::set<std::shared_ptr<Object>>>&, const std::map<Pattern, TableInstance>&, float, std::map<Pattern, std::vector<float>>&);
+extern std::set<Pattern> find_spatial_prev_co_occ(const std::vector<size_t>&, const std::map<Pattern, TableInstance>&, float, std::map<Pattern, std::vector<float>>&);
 TEST_CASE( "find_spatial_prev_co_occ", "[algorithm]" ) {
-    const EventType a{ "A" };
-    const EventType b{ "B" };
+    const EventType a{ 0 };
+    const EventType b{ 1 };
+
+    const ObjectStore objects( {
+        Object( a, 1, 0, 0, 0 ),
+        Object( a, 2, 0, 0, 0 ),
+        Object( b, 1, 0, 0, 0 ),
+        Object( b, 2, 0, 0, 0 ),
+    } );
 
-    const std::shared_ptr<Object> a1 = std::make_shared<Object>( a, 1, 0, 0, 0 );
-    const std::shared_ptr<Object> a2 = std::make_shared<Object>( a, 2, 0, 0, 0 );
-    const std::shared_ptr<Object> b1 = std::make_shared<Object>( b, 1, 0, 0, 0 );
-    const std::shared_ptr<Object> b2 = std::make_shared<Object>( b, 2, 0, 0, 0 );
+    const ObjectIndex a1 = index_of( objects, a, 1 );
+    const ObjectIndex a2 = index_of( objects, a, 2 );
+
+    const ObjectIndex b1 = index_of( objects, b, 1 );
+    const ObjectIndex b2 = index_of( objects, b, 2 );
 
     const Pattern p1{ a, b };
 
@@ -215,10 +347,7 @@ TEST_CASE( "find_spatial_prev_co_occ", "[algorithm]" ) {
         { { a1 }, { b1 } },
     };
 
-    const std::map<EventType, std::set<std::shared_ptr<Object>>> objects_by_type{
-        { a, { a1, a2 } },
-        { b, { b1, b2 } },
-    };
+    const std::vector<size_t> object_count_by_event_type{ 2, 2 };
 
     SECTION( "" ) {
         const std::map<Pattern, TableInstance> t1{
@@ -230,7 +359,7 @@ TEST_CASE( "find_spatial_prev_co_occ", "[algorithm]" ) {
 
             std::map<Pattern, std::vector<float>> spatial_indexes_by_pattern;
 
-            const std::set<Pattern> result = find_spatial_prev_co_occ( objects_by_type, t1, p, spatial_indexes_by_pattern );
+            const std::set<Pattern> result = find_spatial_prev_co_occ( object_count_by_event_type, t1, p, spatial_indexes_by_pattern );
 
             const std::set<Pattern> expected_result{ p1 };
             REQUIRE( expected_result == result );
@@ -240,7 +369,7 @@ TEST_CASE( "find_spatial_prev_co_occ", "[algorithm]" ) {
 
             std::map<Pattern, std::vector<float>> spatial_indexes_by_pattern;
 
-            const std::set<Pattern> result = find_spatial_prev_co_occ( objects_by_type, t1, p, spatial_indexes_by_pattern );
+            const std::set<Pattern> result = find_spatial_prev_co_occ( object_count_by_event_type, t1, p, spatial_indexes_by_pattern );
 
             const std::set<Pattern> expected_result{ p1 };
             REQUIRE( expected_result == result );
@@ -250,7 +379,7 @@ TEST_CASE( "find_spatial_prev_co_occ", "[algorithm]" ) {
 
             std::map<Pattern, std::vector<float>> spatial_indexes_by_pattern;
 
-            const std::set<Pattern> result = find_spatial_prev_co_occ( objects_by_type, t1, p, spatial_indexes_by_pattern );
+            const std::set<Pattern> result = find_spatial_prev_co_occ( object_count_by_event_type, t1, p, spatial_indexes_by_pattern );
 
             const std::set<Pattern> expected_result{};
             REQUIRE( expected_result == result );
@@ -260,7 +389,7 @@ TEST_CASE( "find_spatial_prev_co_occ", "[algorithm]" ) {
 
             std::map<Pattern, std::vector<float>> spatial_indexes_by_pattern;
 
-            const std::set<Pattern> result = find_spatial_prev_co_occ( objects_by_type, t1, p, spatial_indexes_by_pattern );
+            const std::set<Pattern> result = find_spatial_prev_co_occ( object_count_by_event_type, t1, p, spatial_indexes_by_pattern );
 
             const std::set<Pattern> expected_result{};
             REQUIRE( expected_result == result );
@@ -271,9 +400,9 @@ TEST_CASE( "find_spatial_prev_co_occ", "[algorithm]" ) {
 
 extern void find_time_index(std::map<Pattern, float>&, const std::set<Pattern>&, const unsigned);
 TEST_CASE( "find_time_index", "[algorithm]" ) {
-    const EventType a{ "A" };
-    const EventType b{ "B" };
-    const EventType c{ "C" };
+    const EventType a{ 0 };
+    const EventType b{ 1 };
+    const EventType c{ 2 };
 
     SECTION( "" ) {
         const Pattern p1{ a, b };
@@ -303,9 +432,9 @@ TEST_CASE( "find_time_index", "[algorithm]" ) {
 
 extern std::set<Pattern> find_time_prev_co_occ(std::map<Pattern, float>&, const float, const unsigned, const unsigned);
 TEST_CASE( "find_time_prev_co_occ", "[algorithm]" ) {
-    const EventType a{ "A" };
-    const EventType b{ "B" };
-    const EventType c{ "C" };
+    const EventType a{ 0 };
+    const EventType b{ 1 };
+    const EventType c{ 2 };
 
     SECTION( "" ) {
         const Pattern p1{ a, b };
@@ -346,3 +475,1074 @@ TEST_CASE( "find_time_prev_co_occ", "[algorithm]" ) {
         }
     }
 }
+
+
+TEST_CASE( "mine_closed_mdcops", "[algorithm]" ) {
+    // objects of 5 event types scattered around a few centers, which move a bit between 6 time slots
+    std::mt19937 generator( 11 );
+    std::uniform_real_distribution<float> center( 0, 20 );
+    std::normal_distribution<float> offset( 0, 1 );
+
+    std::vector<std::pair<float, float>> centers( 4 );
+    for ( auto& c : centers ) { c = { center( generator ), center( generator ) }; }
+
+    std::vector<Object> objects;
+    std::vector<size_t> object_count_by_event_type( 5, 0 );
+    for ( TimeSlot time_slot = 0; time_slot < 6; ++time_slot ) {
+        for ( size_t i = 0; i < 100; ++i ) {
+            const EventType event_type = (EventType) (i % 5);
+            const std::pair<float, float>& c = centers[(i/5 + time_slot) % centers.size()];
+            objects.push_back( Object( event_type, (ObjectId) object_count_by_event_type[event_type]++,
+                                       c.first + offset( generator ), c.second + offset( generator ), time_slot ) );
+        }
+    }
+    EventTypeDictionary dictionary;
+    for ( const std::string name : { "bus", "car", "taxi", "tram", "bike" } ) { dictionary.intern( name ); }
+    const Dataset st{ dictionary, { 0, 1, 2, 3, 4 }, ObjectStore( objects ), object_count_by_event_type, 6 };
+    const std::shared_ptr<INeighborRelation> r = std::make_shared<EuclideanDistance>( 1.f );
+
+    // mining time slots concurrently gives the results of the sequential run
+    for ( const unsigned time_slot_count : { 4u, 6u } ) {
+        std::streambuf* const cout_buffer = std::cout.rdbuf( nullptr );
+        const std::map<size_t, std::set<Pattern>> cmdp = mine_closed_mdcops( st.event_types, st, { 0, time_slot_count }, r, 0.1f, 0.5f );
+        const std::map<size_t, std::set<Pattern>> cmdp2 = mine_closed_mdcops( st.event_types, st, { 0, time_slot_count }, r, 0.1f, 0.5f, 2 );
+        const std::map<size_t, std::set<Pattern>> cmdp3 = mine_closed_mdcops( st.event_types, st, { 0, time_slot_count }, r, 0.1f, 0.5f, 8 );
+        std::cout.rdbuf( cout_buffer );
+
+        REQUIRE( !cmdp.empty() );
+        REQUIRE( cmdp == cmdp2 );
+        REQUIRE( cmdp == cmdp3 );
+    }
+
+    SECTION( "" ) {
+        // the patterns found for each size are printed with the names of their event types
+        std::ostringstream output;
+        std::streambuf* const cout_buffer = std::cout.rdbuf( output.rdbuf() );
+        mine_closed_mdcops( st.event_types, st, { 0, 6 }, r, 0.1f, 0.5f );
+        std::cout.rdbuf( cout_buffer );
+
+        std::istringstream lines( output.str() );
+        size_t name_count = 0;
+        for ( std::string line; std::getline( lines, line ); ) {
+            if ( line.find( "MDCOPs found (" ) == std::string::npos ) { continue; }
+            INFO( line );
+            std::string patterns = line.substr( line.find( "): " ) + 3 );
+            std::replace_if( patterns.begin(), patterns.end(), [](char c) { return c == '{' || c == '}' || c == ','; }, ' ' );
+            std::istringstream names( patterns );
+            for ( std::string name; names >> name; ++name_count ) { REQUIRE( dictionary.event_types_by_name.count( name ) ); }
+        }
+        REQUIRE( name_count > 0 );
+    }
+}
+
+TEST_CASE( "SlidingWindowMiner", "[sliding_window]" ) {
+    // objects of 4 event types around a few centers, which move between 7 time slots
+    std::mt19937 generator( 3 );
+    std::uniform_real_distribution<float> center( 0, 15 );
+    std::normal_distribution<float> offset( 0, 1 );
+
+    std::vector<std::pair<float, float>> centers( 3 );
+    for ( auto& c : centers ) { c = { center( generator ), center( generator ) }; }
+
+    std::vector<Object> objects;
+    std::vector<size_t> object_count_by_event_type( 4, 0 );
+    for ( TimeSlot time_slot = 0; time_slot < 7; ++time_slot ) {
+        for ( size_t i = 0; i < 60 + 10*time_slot; ++i ) {
+            const EventType event_type = (EventType) ((i + i/7) % 4);
+            const std::pair<float, float>& c = centers[(i/4 + time_slot) % centers.size()];
+            objects.push_back( Object( event_type, (ObjectId) object_count_by_event_type[event_type]++,
+                                       c.first + offset( generator ), c.second + offset( generator ), time_slot ) );
+        }
+    }
+    EventTypeDictionary dictionary;
+    for ( const std::string name : { "A", "B", "C", "D" } ) { dictionary.intern( name ); }
+    const Dataset st{ dictionary, { 0, 1, 2, 3 }, ObjectStore( objects ), object_count_by_event_type, 7 };
+    const std::shared_ptr<INeighborRelation> r = std::make_shared<EuclideanDistance>( 1.f );
+
+    // each window gives the results of mining it from scratch, also with the denominators of the window
+    size_t found_cmdp_count = 0;
+    for ( const unsigned thread_count : { 1u, 3u } ) {
+        for ( const bool window_denominators : { false, true } ) {
+            SlidingWindowMiner miner( st, r, 0.1f, 0.5f, thread_count );
+            for ( TimeSlot first_time_slot = 0; first_time_slot + 3 <= 7; ++first_time_slot ) {
+                const std::pair<TimeSlot, unsigned> window = { first_time_slot, 3 };
+                Dataset window_st = st;
+                if ( window_denominators ) { restrict_denominators_to_window( window_st, window ); }
+
+                std::streambuf* const cout_buffer = std::cout.rdbuf( nullptr );
+                const std::map<size_t, std::set<Pattern>> expected_cmdp = mine_closed_mdcops( st.event_types, window_st, window, r, 0.1f, 0.5f );
+                std::cout.rdbuf( cout_buffer );
+
+                REQUIRE( miner.mine( window, window_st.object_count_by_event_type ) == expected_cmdp );
+                REQUIRE( miner.time_slots.size() == 3 );
+                if ( !expected_cmdp.empty() ) { ++found_cmdp_count; }
+            }
+        }
+    }
+    REQUIRE( found_cmdp_count > 0 );
+
+    // a sweep over several thresholds gives the results of mining each pair of them from scratch, in any order
+    const std::vector<std::pair<float, float>> thresholds = { { 0.2f, 0.5f }, { 0.05f, 0.3f }, { 0.1f, 0.9f }, { 0.3f, 0.2f }, { 0.05f, 0.3f } };
+    SlidingWindowMiner miner( st, r, 0.05f, 0.2f, 2 );
+    for ( TimeSlot first_time_slot = 0; first_time_slot + 4 <= 7; first_time_slot += 3 ) {
+        const std::pair<TimeSlot, unsigned> window = { first_time_slot, 4 };
+        const std::vector<std::map<size_t, std::set<Pattern>>> cmdps = miner.mine( window, st.object_count_by_event_type, thresholds );
+        REQUIRE( cmdps.size() == thresholds.size() );
+        for ( size_t i = 0; i < thresholds.size(); ++i ) {
+            std::streambuf* const cout_buffer = std::cout.rdbuf( nullptr );
+            const std::map<size_t, std::set<Pattern>> expected_cmdp =
+                mine_closed_mdcops( st.event_types, st, window, r, thresholds[i].first, thresholds[i].second );
+            std::cout.rdbuf( cout_buffer );
+
+            REQUIRE( cmdps[i] == expected_cmdp );
+        }
+    }
+
+    // so does a sweep over several neighbor relations, whose instances are the ones of the greatest threshold of a small enough diameter
+    const std::vector<std::shared_ptr<INeighborRelation>> relations = {
+        std::make_shared<EuclideanDistance>( 0.6f ), std::make_shared<EuclideanDistance>( 1.2f ), std::make_shared<EuclideanDistance>( 0.9f )
+    };
+    SlidingWindowMiner diameters_miner( st, relations[1], 0.05f, 0.2f, 2 );
+    diameters_miner.record_diameters = true;
+    for ( TimeSlot first_time_slot = 0; first_time_slot + 4 <= 7; first_time_slot += 2 ) {
+        const std::pair<TimeSlot, unsigned> window = { first_time_slot, 4 };
+        const std::vector<std::map<size_t, std::set<Pattern>>> cmdps =
+            diameters_miner.mine( window, st.object_count_by_event_type, thresholds, relations );
+        REQUIRE( cmdps.size() == relations.size() * thresholds.size() );
+        for ( size_t i = 0; i < cmdps.size(); ++i ) {
+            const std::pair<float, float>& pair = thresholds[i % thresholds.size()];
+            std::streambuf* const cout_buffer = std::cout.rdbuf( nullptr );
+            const std::map<size_t, std::set<Pattern>> expected_cmdp =
+                mine_closed_mdcops( st.event_types, st, window, relations[i / thresholds.size()], pair.first, pair.second );
+            std::cout.rdbuf( cout_buffer );
+
+            REQUIRE( cmdps[i] == expected_cmdp );
+        }
+    }
+}
+
+
+TEST_CASE( "PrevalenceCache", "[prevalence_cache]" ) {
+    const std::string directory_path = "ClosedMDCOP-Miner-tests-cache";
+    std::vector<std::string> file_paths;
+
+    std::vector<Object> objects;
+    std::mt19937 generator( 7 );
+    std::uniform_real_distribution<float> coordinate( 0, 6 );
+    for ( TimeSlot time_slot = 0; time_slot < 3; ++time_slot ) {
+        for ( size_t i = 0; i < 90; ++i ) {
+            objects.push_back( Object( (EventType) (i % 3), (ObjectId) (i/3 + 30*time_slot), coordinate( generator ), coordinate( generator ), time_slot ) );
+        }
+    }
+    Dataset st{ EventTypeDictionary(), { 0, 1, 2 }, ObjectStore( objects ), { 90, 90, 90 }, 3 };
+    for ( const std::string name : { "A", "B", "C" } ) { st.event_type_dictionary.intern( name ); }
+
+    {
+        PrevalenceCache cache( directory_path, "euclidean", 1.f );
+        // keys depend on the objects of the time slot, the event type names and the neighbor relation
+        REQUIRE( cache.key( st, 0 ) != cache.key( st, 1 ) );
+        REQUIRE( cache.key( st, 0 ) == PrevalenceCache( directory_path, "euclidean", 1.f ).key( st, 0 ) );
+        REQUIRE( cache.key( st, 0 ) != PrevalenceCache( directory_path, "euclidean", 2.f ).key( st, 0 ) );
+        REQUIRE( cache.key( st, 0 ) != PrevalenceCache( directory_path, "latlon", 1.f ).key( st, 0 ) );
+
+        const std::map<Pattern, std::vector<size_t>> counts = { { Pattern{ 0, 1 }, { 3, 4 } }, { Pattern{ 0, 1, 70 }, { 1, 2, 1 } } };
+        std::map<Pattern, std::vector<size_t>> loaded_counts;
+        REQUIRE( !cache.load( 42, loaded_counts ) );
+        REQUIRE( cache.store( 42, counts ) );
+        REQUIRE( cache.load( 42, loaded_counts ) );
+        REQUIRE( loaded_counts == counts );
+        REQUIRE( cache.hit_count == 1 );
+        REQUIRE( cache.miss_count == 1 );
+        REQUIRE( cache.read_byte_count == cache.written_byte_count );
+
+        // damaged files are misses
+        file_paths.push_back( directory_path + "/000000000000002a.bin" );
+        std::ofstream( file_paths.back(), std::ios::binary | std::ios::app ) << "x";
+        REQUIRE( !cache.load( 42, loaded_counts ) );
+    }
+
+    // a second miner finds everything in the cache, and mines the same patterns without any join
+    const std::shared_ptr<INeighborRelation> r = std::make_shared<EuclideanDistance>( 1.f );
+    std::map<size_t, std::set<Pattern>> cmdp;
+    for ( size_t run = 0; run < 2; ++run ) {
+        SlidingWindowMiner miner( st, r, 0.2f, 0.5f );
+        miner.cache = std::make_shared<PrevalenceCache>( directory_path, "euclidean", 1.f );
+        const std::map<size_t, std::set<Pattern>> run_cmdp = miner.mine( { 0, 3 }, st.object_count_by_event_type );
+        if ( run == 0 ) {
+            cmdp = run_cmdp;
+            REQUIRE( miner.cache->miss_count == 3 );
+            REQUIRE( miner.join_count > 0 );
+            for ( TimeSlot time_slot = 0; time_slot < 3; ++time_slot ) {
+                std::ostringstream file_path;
+                file_path << directory_path << "/" << std::hex << std::setw( 16 ) << std::setfill( '0' ) << miner.cache->key( st, time_slot ) << ".bin";
+                file_paths.push_back( file_path.str() );
+            }
+        }
+        else {
+            REQUIRE( run_cmdp == cmdp );
+            REQUIRE( miner.cache->hit_count == 3 );
+            REQUIRE( miner.join_count == 0 );
+            REQUIRE( miner.cache->written_byte_count == 0 );
+        }
+    }
+    REQUIRE( !cmdp.empty() );
+
+    for ( const std::string& file_path : file_paths ) { std::remove( file_path.c_str() ); }
+    std::remove( directory_path.c_str() );
+}
+
+
+TEST_CASE( "LatLonChordDistance", "[distances]" ) {
+    // the decisions of the chord and of the float haversine, against the distance found with doubles, for pairs of objects whose
+    // distance is within 1e-3 of dt
+    const auto distance = [](const Object& object1, const Object& object2) {
+        const double to_rad = 3.14159265358979323846/180;
+        const double dphi = ((double) object2.x - object1.x) * to_rad;
+        const double dlambda = ((double) object2.y - object1.y) * to_rad;
+        const double a = std::sin( dphi/2 ) * std::sin( dphi/2 )
+                         + std::cos( object1.x * to_rad ) * std::cos( object2.x * to_rad ) * std::sin( dlambda/2 ) * std::sin( dlambda/2 );
+        return 6371 * 2 * std::atan2( std::sqrt( a ), std::sqrt( 1-a ) );
+    };
+
+    std::mt19937 generator( 5 );
+    std::uniform_real_distribution<double> unit( 0, 1 );
+    for ( const float dt : { 0.05f, 2.f, 50.f, 800.f } ) {
+        LatLonDistance haversine( dt );
+        LatLonChordDistance chord( dt );
+
+        size_t disagreement_count = 0;
+        double max_chord_error = 0, max_haversine_error = 0;  // the greatest relative distance from dt of a wrong decision
+        for ( size_t i = 0; i < 20000; ++i ) {
+            // the point at the given distance and bearing from a random point
+            const double lat = (-80 + 160*unit( generator )) * 3.14159265358979323846/180;
+            const double lon = (-180 + 360*unit( generator )) * 3.14159265358979323846/180;
+            const double bearing = 2 * 3.14159265358979323846 * unit( generator );
+            const double angle = dt * (1 + (2*unit( generator ) - 1) * 1e-3) / 6371;
+            const double lat2 = std::asin( std::sin( lat )*std::cos( angle ) + std::cos( lat )*std::sin( angle )*std::cos( bearing ) );
+            const double lon2 = lon + std::atan2( std::sin( bearing )*std::sin( angle )*std::cos( lat ), std::cos( angle ) - std::sin( lat )*std::sin( lat2 ) );
+            const Object object1( 0, 0, (float) (lat * 180/3.14159265358979323846), (float) (lon * 180/3.14159265358979323846), 0 );
+            const Object object2( 1, 0, (float) (lat2 * 180/3.14159265358979323846), (float) (lon2 * 180/3.14159265358979323846), 0 );
+
+            const double d = distance( object1, object2 );
+            const bool neighbors = d <= dt;
+            const bool chord_neighbors = chord.neighbors( object1, object2 );
+            const bool haversine_neighbors = haversine.neighbors( object1, object2 );
+            if ( chord_neighbors != neighbors ) { max_chord_error = std::max( max_chord_error, std::abs( d-dt )/dt ); }
+            if ( haversine_neighbors != neighbors ) { max_haversine_error = std::max( max_haversine_error, std::abs( d-dt )/dt ); }
+            if ( chord_neighbors != haversine_neighbors ) { ++disagreement_count; }
+
+            REQUIRE( (chord.separation( object1, object2 ) <= chord.max_separation()) == chord_neighbors );
+        }
+
+        INFO( "dt " << dt << ": " << disagreement_count << " disagreements, chord off by " << max_chord_error << ", haversine off by "
+              << max_haversine_error );
+        REQUIRE( max_chord_error < 1e-6 );
+        REQUIRE( max_haversine_error < 1e-3 );
+        REQUIRE( disagreement_count < 20 );
+    }
+}
+
+TEST_CASE( "LatLonDistance", "[distances]" ) {
+    // the bounding boxes never reject neighbors, also close to the poles and across the antimeridian, for pairs about dt apart
+    std::mt19937 generator( 3 );
+    std::uniform_real_distribution<double> unit( 0, 1 );
+    for ( const float dt : { 0.05f, 2.f, 50.f, 800.f, 6000.f } ) {
+        std::vector<Object> objects;
+        for ( ObjectId id = 0; id < 600; id += 2 ) {
+            const double lat = (id % 3 == 0 ? 89.9 - unit( generator ) : -90 + 180*unit( generator )) * 3.14159265358979323846/180;
+            const double lon = (id % 5 == 0 ? 179.9 + 0.2*unit( generator ) : -180 + 360*unit( generator )) * 3.14159265358979323846/180;
+            const double bearing = 2 * 3.14159265358979323846 * unit( generator );
+            const double angle = dt * (1 + (2*unit( generator ) - 1) * (id % 4 == 0 ? 1e-3 : 5e-2)) / 6371;
+            const double lat2 = std::asin( std::sin( lat )*std::cos( angle ) + std::cos( lat )*std::sin( angle )*std::cos( bearing ) );
+            double lon2 = lon + std::atan2( std::sin( bearing )*std::sin( angle )*std::cos( lat ), std::cos( angle ) - std::sin( lat )*std::sin( lat2 ) );
+            lon2 = std::remainder( lon2, 2*3.14159265358979323846 );
+            objects.push_back( Object( 0, id, (float) (lat * 180/3.14159265358979323846), (float) std::remainder( lon * 180/3.14159265358979323846, 360. ), 0 ) );
+            objects.push_back( Object( 1, id+1, (float) (lat2 * 180/3.14159265358979323846), (float) (lon2 * 180/3.14159265358979323846), 0 ) );
+        }
+        const ObjectStore st( objects );
+        const LatLonDistance r( dt );
+        const LatLonDistance::Kernel kernel = r.kernel( st, st.time_slot_range( 0 ) );
+
+        size_t neighbor_count = 0, rejected_neighbor_count = 0;
+        for ( ObjectIndex object1 = 0; object1 < st.size(); ++object1 ) {
+            for ( ObjectIndex object2 = 0; object2 < st.size(); ++object2 ) {
+                if ( !r.neighbors( st.x[object1], st.y[object1], st.x[object2], st.y[object2] ) ) { continue; }
+                ++neighbor_count;
+                if ( !kernel.in_box( object1, object2 ) ) { ++rejected_neighbor_count; }
+            }
+        }
+        INFO( "dt " << dt << ": " << neighbor_count << " neighbors" );
+        REQUIRE( neighbor_count > st.size() );
+        REQUIRE( rejected_neighbor_count == 0 );
+
+        // the kernel tests blocks with the boxes, counting the pairs it rejects
+        size_t test_count = 0;
+        for ( ObjectIndex object1 = 0; object1 < st.size(); object1 += 5 ) {
+            for ( ObjectIndex first = 0; first < st.size(); first += NEIGHBOR_BLOCK_SIZE ) {
+                const unsigned count = std::min<unsigned>( NEIGHBOR_BLOCK_SIZE, st.size()-first );
+                uint64_t mask = 0;
+                for ( unsigned i = 0; i < count; ++i ) {
+                    if ( r.neighbors( st.x[object1], st.y[object1], st.x[first+i], st.y[first+i] ) ) { mask |= uint64_t( 1 ) << i; }
+                }
+                REQUIRE( kernel.neighbors( object1, first, count ) == mask );
+                test_count += count;
+            }
+        }
+        REQUIRE( r.box_test_count == test_count );
+        if ( dt < 1000 ) { REQUIRE( r.box_rejected_count > test_count/2 ); }
+        REQUIRE( r.box_rejected_count <= test_count );
+    }
+}
+
+TEST_CASE( "neighbor kernels", "[neighbor_kernels]" ) {
+    // every version the CPU supports takes the decisions of the kernels of the relations, for blocks of any size
+    std::mt19937 generator( 11 );
+    std::uniform_real_distribution<float> coordinate( -5, 5 );
+    std::uniform_real_distribution<float> latitude( -80, 80 );
+    std::uniform_real_distribution<float> longitude( -180, 180 );
+
+    std::vector<Object> objects;
+    for ( ObjectId id = 0; id < 400; ++id ) { objects.push_back( Object( 0, id, coordinate( generator ), coordinate( generator ), 0 ) ); }
+    // some pairs exactly at the threshold
+    objects.push_back( Object( 0, 400, 0, 0, 0 ) );
+    objects.push_back( Object( 0, 401, 3, 4, 0 ) );
+    objects.push_back( Object( 0, 402, -3, 4, 0 ) );
+    const ObjectStore st( objects );
+
+    std::vector<Object> lat_lon_objects;
+    for ( ObjectId id = 0; id < 400; ++id ) { lat_lon_objects.push_back( Object( 0, id, latitude( generator ), longitude( generator ), 0 ) ); }
+    const ObjectStore lat_lon_st( lat_lon_objects );
+
+    const EuclideanDistance euclidean( 5.f );
+    const EuclideanDistance::Kernel euclidean_kernel = euclidean.kernel( st, st.time_slot_range( 0 ) );
+    const LatLonChordDistance chord( 3000.f );
+    const LatLonChordDistance::Kernel chord_kernel = chord.kernel( lat_lon_st, lat_lon_st.time_slot_range( 0 ) );
+
+    const std::string best_instruction_set = neighbor_kernels_instruction_set();
+    for ( const std::string instruction_set : { "avx2", "sse2", "scalar" } ) {
+        if ( !set_neighbor_kernels_instruction_set( instruction_set ) ) { continue; }
+        INFO( instruction_set );
+        REQUIRE( neighbor_kernels_instruction_set() == instruction_set );
+
+        for ( ObjectIndex object1 = 0; object1 < st.size(); object1 += 7 ) {
+            for ( ObjectIndex first = 0; first < st.size(); first += 13 ) {
+                const unsigned count = std::min<unsigned>( (first*object1) % (NEIGHBOR_BLOCK_SIZE+1), st.size()-first );
+                REQUIRE( euclidean_kernel.neighbors( object1, first, count ) == neighbors_one_by_one( euclidean_kernel, object1, first, count ) );
+            }
+            const unsigned count = st.size() - 400;
+            REQUIRE( euclidean_kernel.neighbors( object1, 400, count ) == neighbors_one_by_one( euclidean_kernel, object1, 400, count ) );
+        }
+        REQUIRE( euclidean_kernel.neighbors( 400, 400, 3 ) == 0x7 );
+
+        for ( ObjectIndex object1 = 0; object1 < lat_lon_st.size(); object1 += 7 ) {
+            for ( ObjectIndex first = 0; first < lat_lon_st.size(); first += 13 ) {
+                const unsigned count = std::min<unsigned>( (first*object1) % (NEIGHBOR_BLOCK_SIZE+1), lat_lon_st.size()-first );
+                REQUIRE( chord_kernel.neighbors( object1, first, count ) == neighbors_one_by_one( chord_kernel, object1, first, count ) );
+            }
+        }
+    }
+    REQUIRE( set_neighbor_kernels_instruction_set( best_instruction_set ) );
+    REQUIRE( !set_neighbor_kernels_instruction_set( "mmx" ) );
+}
+
+
+TEST_CASE( "GridIndex", "[spatial_index]" ) {
+    const EventType a{ 0 };
+    const EventType b{ 1 };
+
+    std::mt19937 generator( 42 );
+    std::uniform_real_distribution<float> coordinate( -50, 50 );
+
+    std::vector<Object> objects;
+    for ( ObjectId id = 0; id < 500; ++id ) {
+        objects.push_back( Object( id % 2 ? a : b, id, coordinate( generator ), coordinate( generator ), 0 ) );
+    }
+    const ObjectStore st( objects );
+
+    for ( const float dt : { 0.5f, 3.f, 20.f, 1000.f } ) {
+        const std::shared_ptr<INeighborRelation> r = std::make_shared<EuclideanDistance>( dt );
+        const std::shared_ptr<ISpatialIndex> index = std::make_shared<GridIndex>( st, st.time_slot_range( 0 ), dt, r );
+
+        for ( ObjectIndex object = 0; object < st.size(); ++object ) {
+            std::vector<ObjectIndex> neighbors;
+            index->neighbors( object, b, neighbors );
+            std::sort( neighbors.begin(), neighbors.end() );
+
+            std::vector<ObjectIndex> expected_neighbors;
+            for ( ObjectIndex other = 0; other < st.size(); ++other ) {
+                if ( st.event_type[other] == b && r->neighbors( st.object( object ), st.object( other ) ) ) { expected_neighbors.push_back( other ); }
+            }
+            REQUIRE( expected_neighbors == neighbors );
+        }
+    }
+}
+
+TEST_CASE( "KDTreeIndex", "[spatial_index]" ) {
+    const EventType a{ 0 };
+    const EventType b{ 1 };
+
+    // a few dense clusters and sparse objects around them, some of them on the same point
+    std::mt19937 generator( 7 );
+    std::normal_distribution<float> cluster_coordinate( 0, 1 );
+    std::uniform_real_distribution<float> coordinate( -50, 50 );
+
+    std::vector<Object> objects;
+    for ( ObjectId id = 0; id < 2000; ++id ) {
+        const float cx = id % 2 ? -20.f : 30.f;
+        if ( id % 10 == 0 ) { objects.push_back( Object( id % 3 ? a : b, id, coordinate( generator ), coordinate( generator ), 0 ) ); }
+        else if ( id % 10 == 1 ) { objects.push_back( Object( id % 3 ? a : b, id, cx, cx, 0 ) ); }
+        else { objects.push_back( Object( id % 3 ? a : b, id, cx + cluster_coordinate( generator ), cx + cluster_coordinate( generator ), 0 ) ); }
+    }
+    const ObjectStore st( objects );
+
+    for ( const float dt : { 0.05f, 0.5f, 3.f, 1000.f } ) {
+        const std::shared_ptr<EuclideanDistance> r = std::make_shared<EuclideanDistance>( dt );
+        KDTreeIndex index( st, st.time_slot_range( 0 ), dt, r );
+        const EuclideanDistance::Kernel kernel = r->kernel( st, st.time_slot_range( 0 ) );
+
+        for ( ObjectIndex object = 0; object < st.size(); ++object ) {
+            for ( const EventType event_type : { a, b } ) {
+                std::vector<ObjectIndex> expected_neighbors;
+                for ( ObjectIndex other = 0; other < st.size(); ++other ) {
+                    if ( st.event_type[other] == event_type && r->neighbors( st.object( object ), st.object( other ) ) ) { expected_neighbors.push_back( other ); }
+                }
+
+                std::vector<ObjectIndex> neighbors;
+                index.neighbors( object, event_type, neighbors );
+                std::sort( neighbors.begin(), neighbors.end() );
+                REQUIRE( expected_neighbors == neighbors );
+
+                neighbors.clear();
+                index.neighbors( object, event_type, kernel, neighbors );
+                std::sort( neighbors.begin(), neighbors.end() );
+                REQUIRE( expected_neighbors == neighbors );
+            }
+        }
+    }
+
+    SECTION( "tree_suits" ) {
+        // the clusters, but not objects spread evenly over crowded cells
+        REQUIRE( tree_suits( st, st.time_slot_range( 0 ), 0.5f ) );
+        std::vector<Object> even_objects;
+        for ( ObjectId id = 0; id < 2000; ++id ) { even_objects.push_back( Object( a, id, coordinate( generator ), coordinate( generator ), 0 ) ); }
+        const ObjectStore even_st( even_objects );
+        REQUIRE( !tree_suits( even_st, even_st.time_slot_range( 0 ), 20.f ) );
+        REQUIRE( tree_suits( even_st, even_st.time_slot_range( 0 ), 1.f ) );
+    }
+}
+
+TEST_CASE( "GeodesicCellIndex", "[spatial_index]" ) {
+    const EventType a{ 0 };
+    const EventType b{ 1 };
+
+    // objects spread over the sphere, and crowded close to the poles and around the antimeridian
+    std::mt19937 generator( 9 );
+    std::uniform_real_distribution<float> unit( 0, 1 );
+    std::vector<Object> objects;
+    for ( ObjectId id = 0; id < 1200; ++id ) {
+        float lat = (float) (std::asin( 2*unit( generator ) - 1 ) * 180/3.14159265358979323846);
+        float lon = -180 + 360*unit( generator );
+        if ( id % 4 == 1 ) { lat = (id % 8 == 1 ? 1 : -1) * (90 - 3*unit( generator )); }
+        if ( id % 4 == 2 ) { lon = id % 8 == 2 ? 180 - 0.5f*unit( generator ) : -180 + 0.5f*unit( generator ); }
+        if ( id % 20 == 3 ) { lat = 90; }
+        objects.push_back( Object( id % 3 ? a : b, id, lat, lon, 0 ) );
+    }
+    const ObjectStore st( objects );
+
+    for ( const float dt : { 1.f, 50.f, 400.f, 3000.f, 15000.f } ) {
+        for ( const std::shared_ptr<INeighborRelation>& r : std::vector<std::shared_ptr<INeighborRelation>>{
+                std::make_shared<LatLonDistance>( dt ), std::make_shared<LatLonChordDistance>( dt ) } ) {
+            GeodesicCellIndex index( st, st.time_slot_range( 0 ), dt, r );
+
+            size_t neighbor_count = 0;
+            for ( ObjectIndex object = 0; object < st.size(); ++object ) {
+                for ( const EventType event_type : { a, b } ) {
+                    std::vector<ObjectIndex> expected_neighbors;
+                    for ( ObjectIndex other = 0; other < st.size(); ++other ) {
+                        if ( st.event_type[other] == event_type && r->neighbors( st.object( object ), st.object( other ) ) ) { expected_neighbors.push_back( other ); }
+                    }
+                    neighbor_count += expected_neighbors.size();
+
+                    std::vector<ObjectIndex> neighbors;
+                    index.neighbors( object, event_type, neighbors );
+                    std::sort( neighbors.begin(), neighbors.end() );
+                    REQUIRE( expected_neighbors == neighbors );
+                }
+            }
+            REQUIRE( neighbor_count > st.size() );
+            if ( dt <= 50 ) { REQUIRE( index.candidate_fraction() < 0.05 ); }
+        }
+    }
+}
+
+TEST_CASE( "construct_spatial_index", "[spatial_index]" ) {
+    const ObjectStore st( { Object( 0, 0, 0, 0, 0 ) } );
+
+    REQUIRE( spatial_index_kind() == "auto" );
+    REQUIRE( construct_spatial_index( st, st.time_slot_range( 0 ), std::make_shared<EuclideanDistance>( 1.f ) ) );
+    // objects whose pairs are all nearby are tested without an index
+    REQUIRE( !construct_spatial_index( st, st.time_slot_range( 0 ), std::make_shared<LatLonDistance>( 1.f ) ) );
+    std::vector<Object> spread_objects;
+    for ( ObjectId id = 0; id < 100; ++id ) { spread_objects.push_back( Object( 0, id, -80 + 1.6f*id, -180 + 3.6f*id, 0 ) ); }
+    const ObjectStore spread_st( spread_objects );
+    REQUIRE( std::dynamic_pointer_cast<GeodesicCellIndex>( construct_spatial_index( spread_st, spread_st.time_slot_range( 0 ), std::make_shared<LatLonDistance>( 10.f ) ) ) );
+    REQUIRE( std::dynamic_pointer_cast<GeodesicCellIndex>( construct_spatial_index( spread_st, spread_st.time_slot_range( 0 ), std::make_shared<LatLonChordDistance>( 10.f ) ) ) );
+    REQUIRE( !construct_spatial_index( spread_st, spread_st.time_slot_range( 0 ), std::make_shared<LatLonDistance>( 20000.f ) ) );
+
+    REQUIRE( set_spatial_index_kind( "grid" ) );
+    REQUIRE( std::dynamic_pointer_cast<GridIndex>( construct_spatial_index( st, st.time_slot_range( 0 ), std::make_shared<EuclideanDistance>( 1.f ) ) ) );
+    REQUIRE( set_spatial_index_kind( "tree" ) );
+    REQUIRE( std::dynamic_pointer_cast<KDTreeIndex>( construct_spatial_index( st, st.time_slot_range( 0 ), std::make_shared<EuclideanDistance>( 1.f ) ) ) );
+    REQUIRE( !construct_spatial_index( st, st.time_slot_range( 0 ), std::make_shared<LatLonDistance>( 1.f ) ) );
+    REQUIRE( !set_spatial_index_kind( "quadtree" ) );
+    REQUIRE( spatial_index_kind() == "tree" );
+    REQUIRE( set_spatial_index_kind( "auto" ) );
+}
+
+
+TEST_CASE( "ObjectStore", "[object_store]" ) {
+    const ObjectStore st( {
+        Object( 1, 0, 0, 0, 3 ),
+        Object( 0, 0, 1, 1, 3 ),
+        Object( 1, 1, 2, 2, 1 ),
+        Object( 1, 2, 3, 3, 3 ),
+        Object( 0, 1, 4, 4, 1 ),
+    } );
+
+    // objects are sorted by time slot, then by event type, then in the order they were added
+    REQUIRE( st.time_slot == (std::vector<TimeSlot>{ 1, 1, 3, 3, 3 }) );
+    REQUIRE( st.event_type == (std::vector<EventType>{ 0, 1, 0, 1, 1 }) );
+    REQUIRE( st.x == (std::vector<float>{ 4, 2, 1, 0, 3 }) );
+
+    REQUIRE( st.time_slot_range( 1 ) == ObjectRange( 0, 2 ) );
+    REQUIRE( st.time_slot_range( 3 ) == ObjectRange( 2, 5 ) );
+    REQUIRE( st.time_slot_range( 2 ).first == st.time_slot_range( 2 ).second );
+
+    REQUIRE( st.event_type_range( st.time_slot_range( 3 ), 1 ) == ObjectRange( 3, 5 ) );
+    const std::vector<std::pair<EventType, ObjectRange>> expected_ranges{ { 0, { 2, 3 } }, { 1, { 3, 5 } } };
+    REQUIRE( st.event_type_ranges( 3 ) == expected_ranges );
+}
+
+
+TEST_CASE( "TableInstance", "[table_instance]" ) {
+    TableInstance table( 2 );
+    REQUIRE( table.empty() );
+    REQUIRE( table.group_count() == 0 );
+
+    // groups without last objects are not added
+    const std::vector<ObjectIndex> prefix1{ 0, 3 };
+    table.close_group( prefix1.data() );
+    REQUIRE( table.group_count() == 0 );
+
+    table.last_objects.push_back( 5 );
+    table.last_objects.push_back( 7 );
+    table.close_group( prefix1.data() );
+
+    const std::vector<ObjectIndex> prefix2{ 1, 4 };
+    table.last_objects.push_back( 6 );
+    table.close_group( prefix2.data() );
+
+    REQUIRE( table.group_count() == 2 );
+    REQUIRE( std::vector<ObjectIndex>( table.prefix( 1 ), table.prefix( 1 ) + 2 ) == prefix2 );
+    REQUIRE( std::vector<ObjectIndex>( table.last_objects_begin( 0 ), table.last_objects_end( 0 ) ) == (std::vector<ObjectIndex>{ 5, 7 }) );
+
+    const TableInstance expected_table{
+        { { 0, 3 }, { 5, 7 } },
+        { { 1, 4 }, { 6 } },
+    };
+    REQUIRE( expected_table == table );
+    REQUIRE( TableInstance{} == TableInstance( 3 ) );
+}
+
+
+struct ManhattanDistance : public INeighborRelation {
+    // a relation known only through INeighborRelation
+    const float dt;
+
+    ManhattanDistance(float dt) : dt( dt ) {}
+
+    virtual bool neighbors(const Object& object1, const Object& object2) { return separation( object1, object2 ) <= dt; }
+    virtual float separation(const Object& object1, const Object& object2) { return std::abs( object1.x-object2.x ) + std::abs( object1.y-object2.y ); }
+    virtual float max_separation() const { return dt; }
+};
+
+TEST_CASE( "NeighborGraph", "[neighbor_graph]" ) {
+    const EventType a{ 0 };
+    const EventType b{ 1 };
+    const EventType c{ 2 };
+
+    std::mt19937 generator( 7 );
+    std::uniform_real_distribution<float> coordinate( -10, 10 );
+
+    std::vector<Object> objects;
+    for ( ObjectId id = 0; id < 300; ++id ) {
+        const EventType event_type = id % 3 == 0 ? a : (id % 3 == 1 ? b : c);
+        objects.push_back( Object( event_type, id, coordinate( generator ), coordinate( generator ), id % 2 ) );
+    }
+    const ObjectStore st( objects );
+
+    // the graphs built through the grid, tree and geodesic cell indexes and the ones built by testing all pairs, with the kernels
+    // of the distances or through INeighborRelation, agree with r
+    for ( const std::string kind : { "grid", "tree" } ) {
+        REQUIRE( set_spatial_index_kind( kind ) );
+        for ( const std::shared_ptr<INeighborRelation>& r : std::vector<std::shared_ptr<INeighborRelation>>{
+                std::make_shared<EuclideanDistance>( 1.5f ), std::make_shared<LatLonDistance>( 150.f ), std::make_shared<LatLonChordDistance>( 150.f ),
+                std::make_shared<LatLonDistance>( 40.f ), std::make_shared<LatLonChordDistance>( 40.f ), std::make_shared<ManhattanDistance>( 2.f ) } ) {
+            for ( const TimeSlot time_slot : { 0, 1 } ) {
+                const NeighborGraph graph( st, time_slot, r, 0, true );
+                const ObjectRange range = st.time_slot_range( time_slot );
+                REQUIRE( graph.objects == range );
+                for ( ObjectIndex object1 = range.first; object1 < range.second; ++object1 ) {
+                    for ( size_t i = graph.offsets[object1-range.first]; i < graph.offsets[object1-range.first+1]; ++i ) {
+                        REQUIRE( graph.separations[i] == r->separation( st.object( object1 ), st.object( graph.neighbors[i] ) ) );
+                    }
+                }
+
+                for ( ObjectIndex object1 = range.first; object1 < range.second; ++object1 ) {
+                    std::vector<ObjectIndex> expected_neighbors;
+                    for ( ObjectIndex object2 = range.first; object2 < range.second; ++object2 ) {
+                        if ( st.event_type[object1] < st.event_type[object2] && r->neighbors( st.object( object1 ), st.object( object2 ) ) ) {
+                            expected_neighbors.push_back( object2 );
+                        }
+                    }
+
+                    const std::pair<const ObjectIndex*, const ObjectIndex*> neighbors = graph.neighbors_of( object1 );
+                    REQUIRE( expected_neighbors == std::vector<ObjectIndex>( neighbors.first, neighbors.second ) );
+                }
+            }
+        }
+    }
+    REQUIRE( set_spatial_index_kind( "auto" ) );
+
+    SECTION( "" ) {
+        // size-2 instances are the pairs of neighbor objects
+        const std::shared_ptr<INeighborRelation> r = std::make_shared<EuclideanDistance>( 2.f );
+        const NeighborGraph graph( st, 1, r );
+
+        std::map<Pattern, TableInstance> prev_t;
+        for ( const auto& pair : st.event_type_ranges( 1 ) ) {
+            TableInstance table( 0 );
+            for ( ObjectIndex object = pair.second.first; object < pair.second.second; ++object ) { table.last_objects.push_back( object ); }
+            table.close_group( nullptr );
+            prev_t[{ pair.first }] = table;
+        }
+
+        const std::map<Pattern, SubPatterns> candidate_patterns{
+            { { a, c }, { { a }, { c } } }
+        };
+
+        TableInstance expected_table( 1 );
+        for ( const ObjectIndex object1 : prev_t.at( { a } ).last_objects ) {
+            for ( const ObjectIndex object2 : prev_t.at( { c } ).last_objects ) {
+                if ( r->neighbors( st.object( object1 ), st.object( object2 ) ) ) { expected_table.last_objects.push_back( object2 ); }
+            }
+            expected_table.close_group( &object1 );
+        }
+
+        ThreadPool pool( 3 );
+        const std::map<Pattern, TableInstance> t = gen_co_occ_inst( candidate_patterns, prev_t, graph, pool );
+        REQUIRE( expected_table == t.at( { a, c } ) );
+        REQUIRE( !expected_table.empty() );
+    }
+
+    SECTION( "" ) {
+        // joins split over threads give the tables of sequential joins, also when their ranges split groups
+        const std::shared_ptr<INeighborRelation> r = std::make_shared<EuclideanDistance>( 8.f );
+        const NeighborGraph graph( st, 0, r );
+
+        std::map<Pattern, TableInstance> prev_t;
+        for ( const auto& pair : st.event_type_ranges( 0 ) ) {
+            TableInstance table( 0 );
+            for ( ObjectIndex object = pair.second.first; object < pair.second.second; ++object ) { table.last_objects.push_back( object ); }
+            table.close_group( nullptr );
+            prev_t[{ pair.first }] = table;
+        }
+        const TableInstance table_ab = join( prev_t.at( { a } ), prev_t.at( { b } ), graph );
+        const TableInstance table_ac = join( prev_t.at( { a } ), prev_t.at( { c } ), graph );
+        REQUIRE( table_ab.last_objects.size() > 600 );
+
+        const TableInstance table_abc = join( table_ab, table_ac, graph );
+        REQUIRE( !table_abc.empty() );
+        for ( const unsigned thread_count : { 1u, 2u, 4u } ) {
+            ThreadPool pool( thread_count );
+            REQUIRE( table_ab == join( prev_t.at( { a } ), prev_t.at( { b } ), graph, pool ) );
+            REQUIRE( table_abc == join( table_ab, table_ac, graph, pool ) );
+        }
+    }
+
+    SECTION( "" ) {
+        // instances record their diameters, and the ones of a smaller threshold are the ones of a small enough diameter
+        const std::shared_ptr<INeighborRelation> r = std::make_shared<EuclideanDistance>( 8.f );
+        const NeighborGraph graph( st, 0, r, 0, true );
+        REQUIRE( graph.separations.size() == graph.neighbors.size() );
+
+        std::map<Pattern, TableInstance> prev_t, plain_prev_t;
+        for ( const auto& pair : st.event_type_ranges( 0 ) ) {
+            TableInstance table( 0 );
+            for ( ObjectIndex object = pair.second.first; object < pair.second.second; ++object ) { table.last_objects.push_back( object ); }
+            table.close_group( nullptr );
+            plain_prev_t[{ pair.first }] = table;
+            table.diameters.assign( table.last_objects.size(), 0.f );
+            prev_t[{ pair.first }] = table;
+        }
+        const TableInstance table_ab = join( prev_t.at( { a } ), prev_t.at( { b } ), graph );
+        const TableInstance table_ac = join( prev_t.at( { a } ), prev_t.at( { c } ), graph );
+        const TableInstance table_abc = join( table_ab, table_ac, graph );
+        REQUIRE( table_abc.diameters.size() == table_abc.last_objects.size() );
+        ThreadPool pool( 4 );
+        REQUIRE( table_abc.diameters == join( table_ab, table_ac, graph, pool ).diameters );
+
+        for ( size_t group = 0; group < table_abc.group_count(); ++group ) {
+            const ObjectIndex* prefix = table_abc.prefix( group );
+            for ( size_t i = table_abc.offsets[group]; i < table_abc.offsets[group+1]; ++i ) {
+                const Object o1 = st.object( prefix[0] ), o2 = st.object( prefix[1] ), o3 = st.object( table_abc.last_objects[i] );
+                REQUIRE( table_abc.diameters[i] == std::max( { r->separation( o1, o2 ), r->separation( o1, o3 ), r->separation( o2, o3 ) } ) );
+            }
+        }
+
+        for ( const float dt : { 3.f, 5.f, 8.f } ) {
+            const std::shared_ptr<INeighborRelation> small_r = std::make_shared<EuclideanDistance>( dt );
+            const NeighborGraph small_graph( st, 0, small_r );
+            const TableInstance small_table_ab = join( plain_prev_t.at( { a } ), plain_prev_t.at( { b } ), small_graph );
+            const TableInstance small_table_ac = join( plain_prev_t.at( { a } ), plain_prev_t.at( { c } ), small_graph );
+            const TableInstance small_table_abc = join( small_table_ab, small_table_ac, small_graph );
+            REQUIRE( find_partecipating_object_counts( { a, b }, small_table_ab ) ==
+                     find_partecipating_object_counts( { a, b }, table_ab, small_r->max_separation() ) );
+            REQUIRE( find_partecipating_object_counts( { a, b, c }, small_table_abc ) ==
+                     find_partecipating_object_counts( { a, b, c }, table_abc, small_r->max_separation() ) );
+        }
+    }
+}
+
+
+TEST_CASE( "ThreadPool", "[thread_pool]" ) {
+    for ( const unsigned thread_count : { 1u, 4u } ) {
+        ThreadPool pool( thread_count );
+
+        SECTION( "" ) {
+            // tasks can spawn and wait for other tasks
+            std::vector<std::atomic<unsigned>> counts( 1000 );
+            for ( std::atomic<unsigned>& count : counts ) { count = 0; }
+
+            parallel_for( pool, 10, [&](size_t i) {
+                parallel_for( pool, 100, [&](size_t j) { ++counts[i*100 + j]; } );
+            } );
+            for ( const std::atomic<unsigned>& count : counts ) { REQUIRE( count == 1 ); }
+        }
+        SECTION( "" ) {
+            // the first exception thrown by a task is rethrown by wait, once all the tasks are done
+            std::atomic<unsigned> count( 0 );
+            REQUIRE_THROWS_AS( parallel_for( pool, 100, [&](size_t i) {
+                ++count;
+                if ( i == 50 ) { throw std::runtime_error( "" ); }
+            } ), std::runtime_error );
+            REQUIRE( count == 100 );
+        }
+    }
+}
+
+
+extern bool parse_line(const char*, const char*, std::pair<const char*, const char*>&, float&, float&, TimeSlot&);
+TEST_CASE( "parse_line", "[dataset]" ) {
+    // lines are parsed as an std::istringstream parses them, including malformed and unusual numbers
+    const std::vector<std::string> fields{
+        "A", "car", "-", "+", ".", "e", "1e", "1e+", ".e1", "0", "-0", "+7", "42", "-1", "4294967295", "4294967296", "-4294967295",
+        "-4294967296", "007", "3.25", "-3.25", ".5", "5.", "5.e2", "1.5e-3", "2E+10", "1.5-2", "1.2.3", "1e39", "-1e39", "1e-39",
+        "1e-46", "3.4028235e38", "16777217", "0.1", "0.30000001", "123456789012345678901234567890", "0.000000000000000000000000001",
+        "1.00000005960464477539062501", "0x10", "inf", "nan", "12abc", "9007199254740993", "\t", "\r", "\v", "  ",
+    };
+    std::mt19937 generator( 13 );
+    std::uniform_int_distribution<size_t> field( 0, fields.size()-1 );
+    std::uniform_int_distribution<size_t> field_count( 0, 6 );
+    std::uniform_int_distribution<int> separator( 0, 3 );
+
+    for ( size_t n = 0; n < 20000; ++n ) {
+        std::string line;
+        const size_t count = field_count( generator );
+        for ( size_t i = 0; i < count; ++i ) {
+            // fields are usually separated by spaces, but not always
+            const int s = separator( generator );
+            if ( i > 0 && s > 0 ) { line += s == 1 ? "\t" : " "; }
+            line += fields[field( generator )];
+        }
+        // well-formed lines in between
+        if ( n % 3 == 0 ) { line = fields[field( generator )] + " " + fields[field( generator )] + " " + fields[field( generator )] + " 1"; }
+
+        std::istringstream iss( line );
+        std::string expected_name;
+        float expected_x, expected_y;
+        TimeSlot expected_time_slot;
+        const bool expected_result = (bool) (iss >> expected_name >> expected_x >> expected_y >> expected_time_slot);
+
+        std::pair<const char*, const char*> name;
+        float x, y;
+        TimeSlot time_slot;
+        const bool result = parse_line( line.data(), line.data() + line.size(), name, x, y, time_slot );
+
+        INFO( line );
+        REQUIRE( expected_result == result );
+        if ( result ) {
+            REQUIRE( expected_name == std::string( name.first, name.second ) );
+            REQUIRE( std::memcmp( &expected_x, &x, sizeof( float ) ) == 0 );
+            REQUIRE( std::memcmp( &expected_y, &y, sizeof( float ) ) == 0 );
+            REQUIRE( expected_time_slot == time_slot );
+        }
+    }
+}
+
+
+TEST_CASE( "construct_dataset", "[dataset]" ) {
+    const std::string dataset_file_path = "ClosedMDCOP-Miner-tests-dataset.txt";
+    {
+        std::ofstream dataset_file( dataset_file_path );
+        dataset_file << "A 1 2 0\nB 3.5 -4 0\n\nmalformed line\nA 1e-3 .5 1\r\nC 0 0 2\n  B\t7 8 1";
+    }
+
+    std::ifstream dataset_file( dataset_file_path );
+    const Dataset expected_dataset = construct_dataset( dataset_file );
+
+    REQUIRE( expected_dataset.event_type_dictionary.names == (std::vector<std::string>{ "A", "B", "C" }) );
+    REQUIRE( expected_dataset.objects.size() == 5 );
+
+    // mapped files give the same dataset, also when split in chunks as small as a few lines
+    for ( const unsigned thread_count : { 1u, 3u } ) {
+        for ( const size_t min_chunk_size : { 1, 5, 4 << 20 } ) {
+            const Dataset dataset = construct_dataset( dataset_file_path, thread_count, { 0, ~0u }, min_chunk_size );
+
+            REQUIRE( expected_dataset.event_type_dictionary.names == dataset.event_type_dictionary.names );
+            REQUIRE( expected_dataset.event_types == dataset.event_types );
+            REQUIRE( expected_dataset.object_count_by_event_type == dataset.object_count_by_event_type );
+            REQUIRE( expected_dataset.objects.event_type == dataset.objects.event_type );
+            REQUIRE( expected_dataset.objects.id == dataset.objects.id );
+            REQUIRE( expected_dataset.objects.x == dataset.objects.x );
+            REQUIRE( expected_dataset.objects.y == dataset.objects.y );
+            REQUIRE( expected_dataset.objects.time_slot == dataset.objects.time_slot );
+        }
+    }
+
+    SECTION( "" ) {
+        // only the objects of the window are kept, with the ids and the denominators of the whole dataset
+        for ( const unsigned thread_count : { 1u, 3u } ) {
+            Dataset dataset = construct_dataset( dataset_file_path, thread_count, { 1, 1 }, 1 );
+            REQUIRE( dataset.event_type_dictionary.names == expected_dataset.event_type_dictionary.names );
+            REQUIRE( dataset.object_count_by_event_type == expected_dataset.object_count_by_event_type );
+            REQUIRE( dataset.time_slot_count == 3 );
+            REQUIRE( dataset.objects.time_slot == (std::vector<TimeSlot>{ 1, 1 }) );
+            REQUIRE( dataset.objects.event_type == (std::vector<EventType>{ 0, 1 }) );
+            REQUIRE( dataset.objects.id == (std::vector<ObjectId>{ 1, 1 }) );
+
+            // the object count printed is the one of the whole dataset, like the counts by event type
+            std::ostringstream info;
+            std::streambuf* const cout_buffer = std::cout.rdbuf( info.rdbuf() );
+            print_dataset_info( dataset );
+            std::cout.rdbuf( cout_buffer );
+            REQUIRE( info.str().find( "object count: 5\n" ) != std::string::npos );
+            REQUIRE( info.str().find( "loaded object count: 2\n" ) != std::string::npos );
+
+            restrict_denominators_to_window( dataset, { 1, 1 } );
+            REQUIRE( dataset.object_count_by_event_type == (std::vector<size_t>{ 1, 1, 0 }) );
+        }
+
+        // a window after the last time slot is clamped to it
+        const Dataset dataset = construct_dataset( dataset_file_path, 1, { 5, 2 } );
+        REQUIRE( dataset.objects.time_slot == (std::vector<TimeSlot>{ 2 }) );
+    }
+    std::remove( dataset_file_path.c_str() );
+}
+
+
+TEST_CASE( "construct_dataset_pipelined", "[pipeline]" ) {
+    // objects of 4 event types around a few centers in 5 time slots, written sorted by time slot
+    const std::string dataset_file_path = "ClosedMDCOP-Miner-tests-pipelined-dataset.txt";
+    {
+        std::mt19937 generator( 5 );
+        std::normal_distribution<float> offset( 0, 1 );
+        std::ofstream dataset_file( dataset_file_path );
+        for ( TimeSlot time_slot = 0; time_slot < 5; ++time_slot ) {
+            for ( size_t i = 0; i < 80; ++i ) {
+                dataset_file << "ABCD"[(i*7 + time_slot) % 4] << " " << 5.f*(i % 3) + offset( generator ) << " " << offset( generator ) << " "
+                             << time_slot << "\n";
+            }
+        }
+    }
+    const std::shared_ptr<INeighborRelation> r = std::make_shared<EuclideanDistance>( 1.f );
+
+    for ( const unsigned thread_count : { 1u, 3u } ) {
+        for ( const std::pair<TimeSlot, unsigned> window : { std::make_pair( 0u, 5u ), std::make_pair( 0u, 3u ) } ) {
+            const Dataset expected_dataset = construct_dataset( dataset_file_path, 1, window );
+
+            Dataset dataset;
+            std::map<TimeSlot, TimeSlotTables> tables;
+            REQUIRE( construct_dataset_pipelined( dataset_file_path, thread_count, window, r, dataset, tables ) );
+            REQUIRE( dataset.event_type_dictionary.names == expected_dataset.event_type_dictionary.names );
+            REQUIRE( dataset.event_types == expected_dataset.event_types );
+            REQUIRE( dataset.object_count_by_event_type == expected_dataset.object_count_by_event_type );
+            REQUIRE( dataset.time_slot_count == expected_dataset.time_slot_count );
+            REQUIRE( dataset.objects.event_type == expected_dataset.objects.event_type );
+            REQUIRE( dataset.objects.id == expected_dataset.objects.id );
+            REQUIRE( dataset.objects.x == expected_dataset.objects.x );
+            REQUIRE( dataset.objects.time_slot == expected_dataset.objects.time_slot );
+            REQUIRE( dataset.objects.ranges_by_time_slot == expected_dataset.objects.ranges_by_time_slot );
+
+            // the graphs of the time slots are the ones of the whole dataset
+            REQUIRE( tables.size() == window.second );
+            for ( const auto& pair : tables ) {
+                const NeighborGraph graph( dataset.objects, pair.first, r );
+                REQUIRE( (*pair.second.graph).objects == graph.objects );
+                REQUIRE( (*pair.second.graph).offsets == graph.offsets );
+                REQUIRE( (*pair.second.graph).neighbors == graph.neighbors );
+            }
+
+            // and mining with the precomputed tables gives the same results
+            std::streambuf* const cout_buffer = std::cout.rdbuf( nullptr );
+            const std::map<size_t, std::set<Pattern>> cmdp = mine_closed_mdcops( dataset.event_types, dataset, window, r, 0.1f, 0.5f );
+            const std::map<size_t, std::set<Pattern>> cmdp2 = mine_closed_mdcops( dataset.event_types, dataset, window, r, 0.1f, 0.5f,
+                                                                                  thread_count, std::move( tables ) );
+            std::cout.rdbuf( cout_buffer );
+            REQUIRE( !cmdp.empty() );
+            REQUIRE( cmdp == cmdp2 );
+        }
+    }
+
+    SECTION( "" ) {
+        // files not sorted by time slot are left to construct_dataset
+        {
+            std::ofstream dataset_file( dataset_file_path );
+            dataset_file << "A 1 2 0\nB 3 4 1\nA 5 6 0\n";
+        }
+        Dataset dataset;
+        std::map<TimeSlot, TimeSlotTables> tables;
+        REQUIRE( !construct_dataset_pipelined( dataset_file_path, 2, { 0, 2 }, r, dataset, tables ) );
+        REQUIRE( dataset.objects.size() == 0 );
+        REQUIRE( tables.empty() );
+    }
+    std::remove( dataset_file_path.c_str() );
+}
+
+
+TEST_CASE( "binary dataset", "[binary_dataset]" ) {
+    const std::string dataset_file_path = "ClosedMDCOP-Miner-tests-dataset.txt";
+    const std::string binary_dataset_file_path = "ClosedMDCOP-Miner-tests-dataset.bin";
+    {
+        std::ofstream dataset_file( dataset_file_path );
+        dataset_file << "A 1 2 3\nB 3.5 -4 0\nA 1e-3 .5 1\nlongest_event_type_name 0 0 2\nB 7 8 1\nA 5 5 0\nB 1 1 3";
+    }
+    const Dataset expected_dataset = construct_dataset( dataset_file_path );
+    REQUIRE( write_binary_dataset( expected_dataset, binary_dataset_file_path ) );
+
+    // binary dataset files are recognized and loaded as they were written
+    const Dataset dataset = construct_dataset( binary_dataset_file_path );
+    REQUIRE( expected_dataset.event_type_dictionary.names == dataset.event_type_dictionary.names );
+    REQUIRE( expected_dataset.event_types == dataset.event_types );
+    REQUIRE( expected_dataset.object_count_by_event_type == dataset.object_count_by_event_type );
+    REQUIRE( expected_dataset.time_slot_count == dataset.time_slot_count );
+    REQUIRE( expected_dataset.objects.ranges_by_time_slot == dataset.objects.ranges_by_time_slot );
+    REQUIRE( expected_dataset.objects.event_type == dataset.objects.event_type );
+    REQUIRE( expected_dataset.objects.id == dataset.objects.id );
+    REQUIRE( expected_dataset.objects.x == dataset.objects.x );
+    REQUIRE( expected_dataset.objects.y == dataset.objects.y );
+    REQUIRE( expected_dataset.objects.time_slot == dataset.objects.time_slot );
+
+    // only the objects of the window are loaded, but the dataset keeps its event types and denominators
+    const Dataset window_dataset = construct_dataset( binary_dataset_file_path, 1, { 1, 2 } );
+    REQUIRE( window_dataset.event_types == expected_dataset.event_types );
+    REQUIRE( window_dataset.object_count_by_event_type == expected_dataset.object_count_by_event_type );
+    REQUIRE( window_dataset.time_slot_count == 4 );
+    REQUIRE( window_dataset.objects.time_slot == (std::vector<TimeSlot>{ 1, 1, 2 }) );
+    for ( const TimeSlot time_slot : { 1, 2 } ) {
+        const ObjectRange range = window_dataset.objects.time_slot_range( time_slot );
+        const ObjectRange expected_range = expected_dataset.objects.time_slot_range( time_slot );
+        REQUIRE( (range.second-range.first) == (expected_range.second-expected_range.first) );
+        for ( ObjectIndex i = 0; i < range.second-range.first; ++i ) {
+            REQUIRE( window_dataset.objects.id[range.first+i] == expected_dataset.objects.id[expected_range.first+i] );
+            REQUIRE( window_dataset.objects.x[range.first+i] == expected_dataset.objects.x[expected_range.first+i] );
+        }
+    }
+    REQUIRE( construct_dataset( binary_dataset_file_path, 1, { 7, 2 } ).objects.time_slot == (std::vector<TimeSlot>{ 3, 3 }) );
+
+    // truncated files are rejected
+    {
+        std::ifstream binary_dataset_file( binary_dataset_file_path, std::ios::binary );
+        const std::string content( (std::istreambuf_iterator<char>( binary_dataset_file )), std::istreambuf_iterator<char>() );
+        std::ofstream( binary_dataset_file_path, std::ios::binary ) << content.substr( 0, content.size()-16 );
+    }
+    REQUIRE_THROWS_AS( construct_dataset( binary_dataset_file_path ), std::runtime_error );
+
+    std::remove( dataset_file_path.c_str() );
+    std::remove( binary_dataset_file_path.c_str() );
+}
+
+
+TEST_CASE( "EventTypeDictionary", "[object]" ) {
+    EventTypeDictionary dictionary;
+
+    REQUIRE( dictionary.intern( "car" ) == 0 );
+    REQUIRE( dictionary.intern( "bus" ) == 1 );
+    REQUIRE( dictionary.intern( "car" ) == 0 );
+    REQUIRE( dictionary.intern( "pedestrian" ) == 2 );
+
+    REQUIRE( dictionary.name( 0 ) == "car" );
+    REQUIRE( dictionary.name( 1 ) == "bus" );
+    REQUIRE( dictionary.name( 2 ) == "pedestrian" );
+    REQUIRE( dictionary.names.size() == 3 );
+}
+
+
+TEST_CASE( "Pattern", "[pattern]" ) {
+    // patterns behave like sets of event types, also beyond the 64 event types of the inline word
+    std::mt19937 generator( 3 );
+
+    for ( const EventType event_type_count : { 10u, 64u, 200u } ) {
+        std::uniform_int_distribution<EventType> event_type( 0, event_type_count-1 );
+        std::uniform_int_distribution<size_t> size( 0, 5 );
+
+        std::vector<std::set<EventType>> sets;
+        std::vector<Pattern> patterns;
+        for ( int i = 0; i < 200; ++i ) {
+            std::set<EventType> set;
+            Pattern pattern;
+            for ( size_t j = size( generator ); j > 0; --j ) {
+                const EventType e = event_type( generator );
+                set.insert( e );
+                pattern.insert( e );
+            }
+            sets.push_back( set );
+            patterns.push_back( pattern );
+
+            REQUIRE( pattern.size() == set.size() );
+            REQUIRE( std::set<EventType>( pattern.cbegin(), pattern.cend() ) == set );
+            if ( !set.empty() ) { REQUIRE( pattern.last() == *set.rbegin() ); }
+        }
+
+        for ( size_t i = 0; i < patterns.size(); ++i ) {
+            for ( size_t j = 0; j < patterns.size(); ++j ) {
+                const std::set<EventType>& set1 = sets[i];
+                const std::set<EventType>& set2 = sets[j];
+                const Pattern& pattern1 = patterns[i];
+                const Pattern& pattern2 = patterns[j];
+
+                REQUIRE( (pattern1 < pattern2) == (set1 < set2) );
+                REQUIRE( (pattern1 == pattern2) == (set1 == set2) );
+                REQUIRE( pattern1.includes( pattern2 ) == std::includes( set1.cbegin(), set1.cend(), set2.cbegin(), set2.cend() ) );
+
+                std::set<EventType> set_union( set1 );
+                set_union.insert( set2.cbegin(), set2.cend() );
+                const Pattern pattern_union = pattern1 | pattern2;
+                REQUIRE( std::set<EventType>( pattern_union.cbegin(), pattern_union.cend() ) == set_union );
+
+                if ( pattern1 == pattern2 ) { REQUIRE( std::hash<Pattern>()( pattern1 ) == std::hash<Pattern>()( pattern2 ) ); }
+            }
+        }
+    }
+
+    SECTION( "" ) {
+        const Pattern pattern{ 3, 70, 130 };
+
+        REQUIRE( pattern.without( 130 ) == (Pattern{ 3, 70 }) );
+        REQUIRE( pattern.without( 130 ).words.size() == 1 );
+        REQUIRE( pattern.without( 70 ).without( 130 ) == Pattern{ 3 } );
+        REQUIRE( pattern.without( 70 ).without( 130 ).words.empty() );
+        REQUIRE( pattern.count( 70 ) );
+        REQUIRE( !pattern.count( 71 ) );
+    }
+}